@@ -0,0 +1,53 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "alloc.hpp"
+
+#ifdef CHESS_DEBUG
+
+// contador por thread: as outras threads (interface, leitura de comandos) podem
+// reservar memória à vontade durante a pesquisa
+static thread_local uint64_t allocations = 0;
+
+static void *counted_alloc(std::size_t n, std::size_t align){
+	allocations++;
+	n = n ? n : 1;
+	void *p = align > alignof(std::max_align_t) ? std::aligned_alloc(align, (n + align - 1) / align * align) : std::malloc(n);
+	if(!p){
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+// as versões de array e nothrow por omissão chamam estas
+void *operator new(std::size_t n){
+	return counted_alloc(n, alignof(std::max_align_t));
+}
+void *operator new(std::size_t n, std::align_val_t a){
+	return counted_alloc(n, std::size_t(a));
+}
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept {
+	std::free(p);
+}
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+#endif
+
+namespace chess {
+
+	uint64_t thread_allocations(void){
+		#ifdef CHESS_DEBUG
+		return allocations;
+		#else
+		return 0;
+		#endif
+	}
+}
@@ -0,0 +1,14 @@
+#ifndef ALLOC_HPP
+#define ALLOC_HPP
+
+#include <cstdint>
+
+namespace chess {
+
+	// Quantos operator new já fez a thread que chama. Com CHESS_DEBUG o operator new
+	// global é substituído para os contar; sem ele devolve sempre 0.
+	// Serve para verificar que a pesquisa não pede memória (ver SearchThread::iterate).
+	uint64_t thread_allocations(void);
+}
+
+#endif // ALLOC_HPP
@@ -0,0 +1,116 @@
+#include <array>
+#include <cstdint>
+#include "attacks.hpp"
+
+namespace chess {
+
+	std::array<Magic, SQUARE_COUNT> ROOK_MAGICS;
+	std::array<Magic, SQUARE_COUNT> BISHOP_MAGICS;
+
+	// Uma só tabela contígua por tipo de peça: cada quadrado aponta para a sua fatia.
+	alignas(64) static std::array<BitBoard, ROOK_TABLE_SIZE> rookTable;
+	alignas(64) static std::array<BitBoard, BISHOP_TABLE_SIZE> bishopTable;
+
+	constexpr int ROOK_DIRS[4][2] { {1,0}, {-1,0}, {0,1}, {0,-1} };
+	constexpr int BISHOP_DIRS[4][2] { {1,1}, {1,-1}, {-1,1}, {-1,-1} };
+
+	constexpr uint64_t MAGIC_SEEDS[8] { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+	static BitBoard sliding_attack(const int (&dirs)[4][2], Square sq, BitBoard occupied);
+	#if !BITBOARD_PEXT
+	static uint64_t prng_next(uint64_t &state);
+	#endif
+	static void init_magics(std::array<Magic, SQUARE_COUNT> &magics, BitBoard *table,
+	                        const int (&dirs)[4][2]);
+
+	// versão lenta, só usada para preencher as tabelas
+	static BitBoard sliding_attack(const int (&dirs)[4][2], Square sq, BitBoard occupied){
+		BitBoard attacks;
+		for(int d = 0; d < 4; d++){
+			int f = square_file(sq) + dirs[d][0];
+			int r = square_rank(sq) + dirs[d][1];
+			while(f >= 0 && f < 8 && r >= 0 && r < 8){
+				Square s = square_new(f, r);
+				attacks.set(s);
+				if(occupied.test(s)){
+					break;
+				}
+				f += dirs[d][0];
+				r += dirs[d][1];
+			}
+		}
+		return attacks;
+	}
+
+	#if !BITBOARD_PEXT
+	// xorshift64*
+	static uint64_t prng_next(uint64_t &state){
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 2685821657736338717ULL;
+	}
+	#endif
+
+	static void init_magics(std::array<Magic, SQUARE_COUNT> &magics, BitBoard *table,
+	                        const int (&dirs)[4][2]){
+		static std::array<BitBoard, 4096> occupancy;
+		static std::array<BitBoard, 4096> reference;
+		int size = 0;
+		#if !BITBOARD_PEXT
+		static std::array<int, 4096> epoch;
+		int cnt = 0;
+		epoch.fill(0);
+		#endif
+
+		for(int i = 0; i < SQUARE_COUNT; i++){
+			Square sq = Square(i);
+			Magic &m = magics[sq];
+
+			BitBoard edges = ((RANK_1_BB | RANK_8_BB) & ~rank_bb(square_rank(sq))) |
+			                 ((FILE_A_BB | FILE_H_BB) & ~file_bb(square_file(sq)));
+			m.mask = sliding_attack(dirs, sq, EMPTY_BB) & ~edges;
+			m.shift = 64 - m.mask.popcount();
+			m.attacks = (i == 0) ? table : magics[i-1].attacks + size;
+
+			// todos os subconjuntos de mask (Carry-Rippler)
+			BitBoard b;
+			size = 0;
+			do {
+				occupancy[size] = b;
+				reference[size] = sliding_attack(dirs, sq, b);
+				#if BITBOARD_PEXT
+				m.attacks[b.pext(m.mask)] = reference[size];
+				#endif
+				size++;
+				b = BitBoard((b.value() - m.mask.value()) & m.mask.value());
+			} while(b);
+
+			#if !BITBOARD_PEXT
+			// procura um multiplicador esparso sem colisões destrutivas;
+			// as sementes por linha foram escolhidas por encontrarem depressa
+			uint64_t seed = MAGIC_SEEDS[square_rank(sq)];
+			for(int k = 0; k < size; ){
+				do {
+					m.magic = prng_next(seed) & prng_next(seed) & prng_next(seed);
+				} while(BitBoard((m.magic * m.mask.value()) >> 56).popcount() < 6);
+
+				for(++cnt, k = 0; k < size; k++){
+					unsigned idx = m.index(occupancy[k]);
+					if(epoch[idx] < cnt){
+						epoch[idx] = cnt;
+						m.attacks[idx] = reference[k];
+					} else if(m.attacks[idx] != reference[k]){
+						break;
+					}
+				}
+			}
+			#endif
+		}
+	}
+
+	void attacks_init(void){
+		init_magics(ROOK_MAGICS, rookTable.data(), ROOK_DIRS);
+		init_magics(BISHOP_MAGICS, bishopTable.data(), BISHOP_DIRS);
+	}
+}
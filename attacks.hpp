@@ -0,0 +1,68 @@
+#ifndef ATTACKS_HPP
+#define ATTACKS_HPP
+
+#include <array>
+#include <cstdint>
+#include "bitboard.hpp"
+#include "chess.hpp"
+
+namespace chess {
+
+	// Ataques das peças deslizantes por "magic bitboards".
+	// Com BMI2 (BITBOARD_PEXT) o índice é um PEXT e o multiplicador não se usa;
+	// a disposição das tabelas é a mesma nos dois casos.
+	struct Magic {
+		BitBoard mask;     // casas relevantes, sem as bordas
+		uint64_t magic;
+		BitBoard *attacks; // início da fatia deste quadrado na tabela
+		int shift;
+
+		unsigned index(BitBoard occupied) const {
+			#if BITBOARD_PEXT
+			return unsigned(occupied.pext(this->mask));
+			#else
+			return unsigned(((occupied & this->mask).value() * this->magic) >> this->shift);
+			#endif
+		}
+	};
+
+	constexpr int ROOK_TABLE_SIZE { 0x19000 };
+	constexpr int BISHOP_TABLE_SIZE { 0x1480 };
+
+	extern std::array<Magic, SQUARE_COUNT> ROOK_MAGICS;
+	extern std::array<Magic, SQUARE_COUNT> BISHOP_MAGICS;
+
+	void attacks_init(void);
+
+	inline BitBoard rook_attacks(Square sq, BitBoard occupied){
+		const Magic &m = ROOK_MAGICS[sq];
+		return m.attacks[m.index(occupied)];
+	}
+	inline BitBoard bishop_attacks(Square sq, BitBoard occupied){
+		const Magic &m = BISHOP_MAGICS[sq];
+		return m.attacks[m.index(occupied)];
+	}
+	inline BitBoard queen_attacks(Square sq, BitBoard occupied){
+		return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied);
+	}
+
+	// ataques de uma peça que não seja peão
+	inline BitBoard piece_attacks(PieceType t, Square sq, BitBoard occupied){
+		switch(t){
+			case PIECE_KNIGHT:
+				return KNIGHT_ATTACKS[sq];
+			case PIECE_BISHOP:
+				return bishop_attacks(sq, occupied);
+			case PIECE_ROOK:
+				return rook_attacks(sq, occupied);
+			case PIECE_QUEEN:
+				return queen_attacks(sq, occupied);
+			case PIECE_KING:
+				return KING_ATTACKS[sq];
+			default:
+				return EMPTY_BB;
+		}
+	}
+}
+
+#endif // ATTACKS_HPP
@@ -0,0 +1,552 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "chess.hpp"
+#include "evaluate.hpp"
+#include "fenfile.hpp"
+#include "nnue.hpp"
+#include "pack.hpp"
+#include "pgn.hpp"
+#include "search.hpp"
+#include "tablebase.hpp"
+#include "threadpool.hpp"
+#include "tt.hpp"
+
+// Mede a pesquisa num conjunto fixo de posições, sem SDL.
+//
+// uso: bench [-d profundidade] [-hash MB] [-t threads] [-nnue ficheiro|random] [-v] [fen]
+//      bench -scale [-d profundidade] [-hash MB] [-t threads] [fen]
+//      bench -compare -nnue ficheiro|random [-d profundidade] [-hash MB] [fen]
+//      bench -fens ficheiro [-t threads]
+//      bench -pgn ficheiro [-t threads]
+//      bench -pack entrada saída [-t threads]
+//      bench -tb material pasta [-t threads]
+//
+// Para cada posição: nós, tempo até à profundidade e nps; no fim, os totais.
+// Com uma thread os nós são determinísticos para a mesma profundidade e tamanho
+// de tabela, por isso servem também para detetar alterações involuntárias na pesquisa.
+//
+// -scale repete o conjunto com 1, 2, 4, ... threads (até -t, por omissão todos
+// os núcleos) e mostra a aceleração do tempo até à profundidade.
+//
+// -nnue pesquisa com a rede em vez da avaliação clássica; "random" usa pesos
+// aleatórios, que jogam mal mas custam o mesmo a calcular.
+// -compare mede as duas avaliações: avaliações por segundo (do_move + avaliação +
+// undo_move sobre as jogadas legais de cada posição, com o acumulador atualizado
+// de forma incremental) e nps da pesquisa com uma e com outra.
+// -fens lê um ficheiro de FENs (uma por linha) com -t threads (por omissão todos os
+// núcleos) e mede posições/s e MB/s; depois volta a escrever cada posição em FEN,
+// confirma que a leitura dá a mesma posição e mede posições/s da escrita.
+// -pgn repete todos os jogos de um ficheiro PGN com -t threads (por omissão todos
+// os núcleos), passando por todas as posições, e mede MB/s, jogos/s e jogadas/s.
+// -pack converte para o formato binário de pack.hpp: um .pgn para jogos, o resto
+// (uma FEN por linha) para posições. Depois lê a saída e confirma que dá o mesmo;
+// mostra os tamanhos e o ritmo de escrita e de leitura.
+// -tb gera a tabela de finais do material ("KQK", "KRPKR") em pasta com -t threads
+// (por omissão todos os núcleos), aproveitando as que já lá estiverem, e mostra o
+// tempo, as vitórias, empates e derrotas e o mate mais longo com cada cor a jogar.
+//
+//      DEBUGFLAGS="-O3 -DNDEBUG" ./compile.sh bench
+
+using chess::Move;
+using chess::Position;
+using chess::Search;
+using chess::SearchLimits;
+using chess::SearchReport;
+using chess::TranspositionTable;
+
+static const char *const POSITIONS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+	"r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R w KQ - 3 9",
+	"2r3k1/pp3pp1/4p2p/3pP3/3P4/P4N2/1P3PPP/2R3K1 w - - 0 25",
+	"8/8/4k3/8/2p5/2P5/4K3/8 w - - 0 1",
+	"8/5pk1/6p1/8/3R4/6P1/r4PK1/8 w - - 0 40",
+	"r1b2rk1/2q1bppp/p2p1n2/np2p3/3PP3/5N1P/PPBN1PP1/R1BQR1K1 w - - 1 13",
+};
+
+struct Totals {
+	uint64_t nodes;
+	double time;
+	chess::TTStats stats;
+	chess::PawnStats pawnStats;
+};
+
+static void usage(const char *prog);
+static void print_report(const SearchReport &r);
+static bool run_positions(Search &search, TranspositionTable &tt, const std::vector<const char *> &fens,
+                          const SearchLimits &limits, bool print, Totals &total);
+static bool run_scale(TranspositionTable &tt, const std::vector<const char *> &fens, const SearchLimits &limits, int maxThreads);
+static double eval_throughput(const Position &root, bool nnue, int reps, int &mismatches);
+static bool run_compare(TranspositionTable &tt, const std::vector<const char *> &fens, const SearchLimits &limits);
+static bool run_fens(const char *path, int threads);
+static bool run_pgn(const char *path, int threads);
+static bool run_pack(const char *in, const char *out, int threads);
+static bool run_tb(const char *material, const char *dir, int threads);
+
+static void print_report(const SearchReport &r){
+	char name[6];
+	printf("  prof %2d/%-2d valor %6d nós %10llu tempo %6lldms nps %9llu hash %4d pv",
+	       r.depth, r.seldepth, r.score, (unsigned long long)r.nodes, (long long)r.timeMs,
+	       (unsigned long long)r.nps, r.hashfull);
+	for(int i = 0; i < r.pvLength; i++){
+		chess::move_name(r.pv[i], name);
+		printf(" %s", name);
+	}
+	printf("\n");
+}
+
+static bool run_positions(Search &search, TranspositionTable &tt, const std::vector<const char *> &fens,
+                          const SearchLimits &limits, bool print, Totals &total){
+	total = Totals();
+	for(size_t i = 0; i < fens.size(); i++){
+		Position pos;
+		if(!Position::from_fen(fens[i], pos)){
+			fprintf(stderr, "FEN inválida: %s\n", fens[i]);
+			return false;
+		}
+		// cada posição começa do zero, para os nós não dependerem da ordem
+		tt.clear();
+		search.clear();
+
+		auto start = std::chrono::steady_clock::now();
+		Move best = search.think(pos, limits);
+		double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		uint64_t nodes = search.node_count();
+		if(print){
+			char name[6];
+			chess::move_name(best, name);
+			printf("%2d %-5s nós %10llu tempo %7.3fs nps %10.0f tt %5.1f%% peões %5.1f%%  %s\n", int(i + 1), name,
+			       (unsigned long long)nodes, t, t > 0 ? nodes / t : 0.0,
+			       100.0 * search.tt_stats().hit_rate(), 100.0 * search.pawn_stats().hit_rate(), fens[i]);
+		}
+		total.nodes += nodes;
+		total.time += t;
+		total.stats += search.tt_stats();
+		total.pawnStats += search.pawn_stats();
+	}
+	return true;
+}
+
+// tempo até à profundidade com 1, 2, 4, ... threads até maxThreads
+static bool run_scale(TranspositionTable &tt, const std::vector<const char *> &fens, const SearchLimits &limits, int maxThreads){
+	std::vector<int> counts;
+	for(int n = 1; n < maxThreads; n *= 2){
+		counts.push_back(n);
+	}
+	counts.push_back(maxThreads);
+
+	double base = 0;
+	printf("threads          nós     tempo            nps  aceleração  eficiência\n");
+	for(int n : counts){
+		Search search(tt, n);
+		Totals total;
+		if(!run_positions(search, tt, fens, limits, false, total)){
+			return false;
+		}
+		if(n == 1){
+			base = total.time;
+		}
+		double speedup = total.time > 0 ? base / total.time : 0.0;
+		printf("%7d %12llu %8.3fs %14.0f %10.2fx %10.0f%%\n", n, (unsigned long long)total.nodes, total.time,
+		       total.time > 0 ? total.nodes / total.time : 0.0, speedup, 100.0 * speedup / n);
+	}
+	return true;
+}
+
+// avaliações por segundo sobre as jogadas legais de root, repetidas reps vezes;
+// mismatches conta os acumuladores incrementais que não batem com um recálculo
+static double eval_throughput(const Position &root, bool nnue, int reps, int &mismatches){
+	Position pos = root;
+	chess::PawnTable pawns;
+	chess::MoveList list;
+	pos.generate_legal(list);
+
+	chess::Accumulator rootAcc, acc, check;
+	chess::nnue_refresh(pos, rootAcc);
+	for(int i = 0; i < list.size(); i++){
+		chess::StateInfo st;
+		chess::DirtyPieces dp;
+		chess::nnue_dirty_pieces(pos, list[i], dp);
+		pos.do_move(list[i], st);
+		chess::nnue_update(pos, dp, rootAcc, acc);
+		chess::nnue_refresh(pos, check);
+		mismatches += memcmp(&acc, &check, sizeof(acc)) != 0;
+		pos.undo_move(list[i], st);
+	}
+
+	// a soma impede o compilador de deitar fora as avaliações
+	int sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(int r = 0; r < reps; r++){
+		for(int i = 0; i < list.size(); i++){
+			chess::StateInfo st;
+			if(nnue){
+				chess::DirtyPieces dp;
+				chess::nnue_dirty_pieces(pos, list[i], dp);
+				pos.do_move(list[i], st);
+				chess::nnue_update(pos, dp, rootAcc, acc);
+				sum += chess::evaluate(pos, pawns, &acc);
+			} else {
+				pos.do_move(list[i], st);
+				sum += chess::evaluate(pos, pawns);
+			}
+			pos.undo_move(list[i], st);
+		}
+	}
+	double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	volatile int sink = sum;
+	(void)sink;
+	return t > 0 ? double(reps) * list.size() / t : 0.0;
+}
+
+static bool run_compare(TranspositionTable &tt, const std::vector<const char *> &fens, const SearchLimits &limits){
+	constexpr int REPS = 20000;
+	double evals[2] = { 0, 0 };
+	int mismatches = 0;
+	for(const char *fen : fens){
+		Position pos;
+		if(!Position::from_fen(fen, pos)){
+			fprintf(stderr, "FEN inválida: %s\n", fen);
+			return false;
+		}
+		evals[0] += eval_throughput(pos, false, REPS, mismatches);
+		evals[1] += eval_throughput(pos, true, REPS, mismatches);
+	}
+	evals[0] /= fens.size();
+	evals[1] /= fens.size();
+
+	Search search(tt, 1);
+	Totals total[2];
+	for(int n = 0; n < 2; n++){
+		chess::nnue_set_enabled(n == 1);
+		if(!run_positions(search, tt, fens, limits, false, total[n])){
+			return false;
+		}
+	}
+
+	printf("avaliação        aval/s            nós     tempo            nps\n");
+	for(int n = 0; n < 2; n++){
+		printf("%-9s %13.0f %14llu %8.3fs %14.0f\n", n == 0 ? "clássica" : "rede", evals[n],
+		       (unsigned long long)total[n].nodes, total[n].time, total[n].time > 0 ? total[n].nodes / total[n].time : 0.0);
+	}
+	printf("\nacumuladores incrementais diferentes do recálculo: %d\n", mismatches);
+	return mismatches == 0;
+}
+
+static bool run_fens(const char *path, int threads){
+	chess::FenFile file(path);
+	if(!file.is_open()){
+		fprintf(stderr, "não foi possível abrir %s\n", path);
+		return false;
+	}
+	chess::ThreadPool pool(threads);
+	std::vector<Position> positions;
+	auto start = std::chrono::steady_clock::now();
+	size_t invalid = file.load(pool, positions);
+	double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("leitura: %zu posições, %zu linhas inválidas, %.3fs com %d threads, %.0f posições/s, %.1f MB/s\n",
+	       positions.size(), invalid, t, threads, t > 0 ? positions.size() / t : 0.0,
+	       t > 0 ? file.bytes() / t / (1 << 20) : 0.0);
+
+	char fen[chess::FEN_MAX];
+	size_t length = 0, mismatches = 0;
+	start = std::chrono::steady_clock::now();
+	for(const Position &pos : positions){
+		length += pos.to_fen(fen);
+	}
+	t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("escrita: %.3fs com 1 thread, %.0f posições/s (%zu bytes)\n", t, t > 0 ? positions.size() / t : 0.0, length);
+
+	for(const Position &pos : positions){
+		Position again;
+		pos.to_fen(fen);
+		mismatches += !Position::from_fen(fen, again) || again.get_key() != pos.get_key() ||
+		              again.halfmove_clock() != pos.halfmove_clock() || again.fullmove_number() != pos.fullmove_number();
+	}
+	printf("FEN escritas que não voltam a dar a mesma posição: %zu\n", mismatches);
+	return mismatches == 0;
+}
+
+static bool run_pgn(const char *path, int threads){
+	chess::PgnFile file(path);
+	if(!file.is_open()){
+		fprintf(stderr, "não foi possível abrir %s\n", path);
+		return false;
+	}
+	chess::ThreadPool pool(threads);
+	// por thread, para não partilharem linhas de cache; o XOR das chaves obriga a fazer as jogadas
+	struct alignas(64) Replayed {
+		uint64_t positions;
+		uint64_t keys;
+	};
+	std::vector<Replayed> replayed(threads, Replayed{0, 0});
+	auto start = std::chrono::steady_clock::now();
+	chess::PgnStats stats = file.replay(pool, [&replayed](int worker, const chess::PgnGame &game){
+		Position pos = game.start;
+		chess::StateInfo st;
+		Replayed &r = replayed[worker];
+		for(int i = 0; i < game.moveCount; i++){
+			pos.do_move(game.moves[i], st);
+			r.keys ^= pos.get_key();
+		}
+		r.positions += game.moveCount + 1;
+	});
+	double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t positions = 0, keys = 0;
+	for(const Replayed &r : replayed){
+		positions += r.positions;
+		keys ^= r.keys;
+	}
+	printf("%llu jogos, %llu jogadas, %llu posições, %llu jogos com erros (chaves: %016llx)\n",
+	       (unsigned long long)stats.games, (unsigned long long)stats.moves, (unsigned long long)positions,
+	       (unsigned long long)stats.errors, (unsigned long long)keys);
+	printf("%.3fs com %d threads: %.1f MB/s, %.0f jogos/s, %.0f jogadas/s\n", t, threads,
+	       t > 0 ? file.bytes() / t / (1 << 20) : 0.0, t > 0 ? stats.games / t : 0.0, t > 0 ? stats.moves / t : 0.0);
+	return true;
+}
+
+static bool run_pack(const char *in, const char *out, int threads){
+	size_t len = strlen(in);
+	bool games = len >= 4 && !strcmp(in + len - 4, ".pgn");
+	chess::ThreadPool pool(threads);
+	chess::PackWriter writer(out, games ? chess::PACK_GAMES : chess::PACK_POSITIONS);
+	if(!writer.is_open()){
+		fprintf(stderr, "não foi possível criar %s\n", out);
+		return false;
+	}
+
+	// o que se escreveu, para comparar com o que se lê: registos, jogadas e XOR das chaves
+	uint64_t records = 0, moves = 0, keys = 0, inBytes = 0;
+	bool ok = true;
+	auto start = std::chrono::steady_clock::now();
+	if(games){
+		chess::PgnFile file(in);
+		if(!file.is_open()){
+			fprintf(stderr, "não foi possível abrir %s\n", in);
+			return false;
+		}
+		inBytes = file.bytes();
+		std::mutex lock;
+		file.replay(pool, [&](int, const chess::PgnGame &game){
+			std::lock_guard<std::mutex> guard(lock);
+			ok &= writer.write_game(game.start, game.moves, game.moveCount, game.result);
+			records++;
+			moves += game.moveCount;
+			keys ^= game.start.get_key();
+		});
+	} else {
+		chess::FenFile file(in);
+		if(!file.is_open()){
+			fprintf(stderr, "não foi possível abrir %s\n", in);
+			return false;
+		}
+		inBytes = file.bytes();
+		std::vector<Position> positions;
+		file.load(pool, positions);
+		for(const Position &pos : positions){
+			ok &= writer.write(pos);
+			keys ^= pos.get_key();
+		}
+		records = positions.size();
+	}
+	ok &= writer.close();
+	double tw = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if(!ok){
+		fprintf(stderr, "erro a escrever %s\n", out);
+		return false;
+	}
+
+	chess::PackReader reader(out);
+	uint64_t readRecords = 0, readMoves = 0, readKeys = 0;
+	start = std::chrono::steady_clock::now();
+	Position pos;
+	if(games){
+		std::vector<Move> list;
+		chess::PgnResult result;
+		while(reader.read_game(pos, list, result)){
+			readRecords++;
+			readMoves += list.size();
+			readKeys ^= pos.get_key();
+		}
+	} else {
+		while(reader.read(pos)){
+			readRecords++;
+			readKeys ^= pos.get_key();
+		}
+	}
+	double tr = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	long outBytes = 0;
+	if(FILE *f = fopen(out, "rb")){
+		fseek(f, 0, SEEK_END);
+		outBytes = ftell(f);
+		fclose(f);
+	}
+
+	printf("%llu %s: %llu bytes -> %ld bytes (%.1fx; %zu bytes por Position em memória)\n",
+	       (unsigned long long)records, games ? "jogos" : "posições", (unsigned long long)inBytes,
+	       outBytes, outBytes > 0 ? double(inBytes) / outBytes : 0.0, sizeof(Position));
+	printf("escrita: %.3fs (com a leitura da entrada), leitura: %.3fs, %.0f registos/s, %.1f MB/s\n",
+	       tw, tr, tr > 0 ? readRecords / tr : 0.0, tr > 0 ? outBytes / tr / (1 << 20) : 0.0);
+	bool same = !reader.failed() && readRecords == records && readMoves == moves && readKeys == keys;
+	printf("lido igual ao escrito: %s\n", same ? "sim" : "não");
+	return same;
+}
+
+static bool run_tb(const char *material, const char *dir, int threads){
+	chess::ThreadPool pool(threads);
+	int loaded = chess::tb_load(dir);
+	auto start = std::chrono::steady_clock::now();
+	bool ok = chess::tb_generate(material, dir, pool);
+	double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	chess::TbStats stats;
+	if(!ok || !chess::tb_stats(material, stats)){
+		fprintf(stderr, "não foi possível gerar %s em %s\n", material, dir);
+		return false;
+	}
+	printf("%s: %llu posições no índice, %.3fs com %d threads (%d tabelas já existiam)\n", material,
+	       (unsigned long long)stats.entries, t, threads, loaded);
+	for(int c = 0; c < chess::PIECE_N_COLORS; c++){
+		printf("%s a jogar: %llu vitórias, %llu empates, %llu derrotas, mate mais longo em %d\n",
+		       c == chess::PIECE_WHITE ? "brancas" : "pretas", (unsigned long long)stats.wins[c],
+		       (unsigned long long)stats.draws[c], (unsigned long long)stats.losses[c], (stats.longest[c] + 1) / 2);
+	}
+	return true;
+}
+
+static void usage(const char *prog){
+	fprintf(stderr, "uso: %s [-d profundidade] [-hash MB] [-t threads] [-nnue ficheiro|random] [-v] [fen]\n", prog);
+	fprintf(stderr, "     %s -scale [-d profundidade] [-hash MB] [-t threads] [fen]\n", prog);
+	fprintf(stderr, "     %s -compare -nnue ficheiro|random [-d profundidade] [-hash MB] [fen]\n", prog);
+	fprintf(stderr, "     %s -fens ficheiro [-t threads]\n", prog);
+	fprintf(stderr, "     %s -pgn ficheiro [-t threads]\n", prog);
+	fprintf(stderr, "     %s -pack entrada saída [-t threads]\n", prog);
+	fprintf(stderr, "     %s -tb material pasta [-t threads]\n", prog);
+}
+
+int main(int argc, char **argv){
+	int depth = 10;
+	size_t hashMB = 16;
+	int threads = 0;
+	bool verbose = false;
+	bool scale = false;
+	bool compare = false;
+	const char *net = nullptr;
+	const char *fenFile = nullptr;
+	const char *pgnFile = nullptr;
+	const char *packIn = nullptr, *packOut = nullptr;
+	const char *tbMaterial = nullptr, *tbDir = nullptr;
+	const char *fen = nullptr;
+
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-d") && i + 1 < argc){
+			depth = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "-hash") && i + 1 < argc){
+			hashMB = strtoull(argv[++i], nullptr, 10);
+		} else if(!strcmp(argv[i], "-t") && i + 1 < argc){
+			threads = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "-v")){
+			verbose = true;
+		} else if(!strcmp(argv[i], "-scale")){
+			scale = true;
+		} else if(!strcmp(argv[i], "-compare")){
+			compare = true;
+		} else if(!strcmp(argv[i], "-nnue") && i + 1 < argc){
+			net = argv[++i];
+		} else if(!strcmp(argv[i], "-fens") && i + 1 < argc){
+			fenFile = argv[++i];
+		} else if(!strcmp(argv[i], "-pgn") && i + 1 < argc){
+			pgnFile = argv[++i];
+		} else if(!strcmp(argv[i], "-pack") && i + 2 < argc){
+			packIn = argv[++i];
+			packOut = argv[++i];
+		} else if(!strcmp(argv[i], "-tb") && i + 2 < argc){
+			tbMaterial = argv[++i];
+			tbDir = argv[++i];
+		} else if(argv[i][0] != '-'){
+			fen = argv[i];
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	// sem -t: uma thread na medição normal (nós reprodutíveis), todos os núcleos nas outras
+	if(threads < 1){
+		threads = scale || fenFile || pgnFile || packIn || tbMaterial ? int(std::thread::hardware_concurrency()) : 1;
+		threads = threads < 1 ? 1 : threads;
+	}
+
+	if(compare && !net){
+		usage(argv[0]);
+		return 2;
+	}
+
+	chess::init();
+	if(fenFile){
+		return run_fens(fenFile, threads) ? 0 : 2;
+	}
+	if(pgnFile){
+		return run_pgn(pgnFile, threads) ? 0 : 2;
+	}
+	if(packIn){
+		return run_pack(packIn, packOut, threads) ? 0 : 2;
+	}
+	if(tbMaterial){
+		return run_tb(tbMaterial, tbDir, threads) ? 0 : 2;
+	}
+	if(net){
+		if(!strcmp(net, "random")){
+			chess::nnue_init_random(1);
+		} else if(!chess::nnue_load(net)){
+			fprintf(stderr, "não foi possível carregar a rede: %s\n", net);
+			return 2;
+		}
+		chess::nnue_set_enabled(true);
+	}
+
+	TranspositionTable tt;
+	tt.resize(hashMB);
+
+	SearchLimits limits;
+	limits.depth = depth;
+
+	std::vector<const char *> fens;
+	if(fen){
+		fens.push_back(fen);
+	} else {
+		fens.assign(POSITIONS, POSITIONS + sizeof(POSITIONS) / sizeof(POSITIONS[0]));
+	}
+
+	if(scale){
+		return run_scale(tt, fens, limits, threads) ? 0 : 2;
+	}
+	if(compare){
+		return run_compare(tt, fens, limits) ? 0 : 2;
+	}
+
+	Search search(tt, threads);
+	if(verbose){
+		search.set_reporter(print_report);
+	}
+	Totals total;
+	if(!run_positions(search, tt, fens, limits, true, total)){
+		return 2;
+	}
+	printf("\nnós: %llu\ntempo: %.3fs\nnps: %.0f\ntt: %.1f%% de acertos em %llu consultas\n",
+	       (unsigned long long)total.nodes, total.time, total.time > 0 ? total.nodes / total.time : 0.0,
+	       100.0 * total.stats.hit_rate(), (unsigned long long)total.stats.probes);
+	printf("peões: %.1f%% de acertos em %llu consultas\n",
+	       100.0 * total.pawnStats.hit_rate(), (unsigned long long)total.pawnStats.probes);
+	return 0;
+}
@@ -1,13 +1,145 @@
 #ifndef BITBOARD_HPP
 #define BITBOARD_HPP
 
-#include <bitset>
+#include <cstdint>
+
+// PEXT/PDEP só quando o compilador gera BMI2 (-mbmi2 / -march=native).
+// Em CPUs onde o PEXT é microcodificado (AMD anteriores a Zen 3) compilar com -DNO_PEXT.
+#if defined(__BMI2__) && !defined(NO_PEXT)
+#define BITBOARD_PEXT 1
+#include <immintrin.h>
+#else
+#define BITBOARD_PEXT 0
+#endif
+
+// Conjunto de 64 quadrados num único uint64_t.
+// bit 0: a1, bit 7: h1, bit 56: a8, bit 63: h8.
+class BitBoard {
+	uint64_t bits;
 
-class BitBoard: public std::bitset<64> {
 	public:
-		BitBoard(): std::bitset<64>{} {}
+		constexpr BitBoard(void): bits{0} {}
+		constexpr explicit BitBoard(uint64_t b): bits{b} {}
+
+		static constexpr BitBoard square(int sq){
+			return BitBoard(uint64_t(1) << sq);
+		}
+
+		constexpr uint64_t value(void) const { return bits; }
+
+		constexpr bool test(int sq) const { return (bits >> sq) & 1; }
+		constexpr bool operator[](int sq) const { return test(sq); }
+		constexpr void set(int sq){ bits |= uint64_t(1) << sq; }
+		constexpr void reset(int sq){ bits &= ~(uint64_t(1) << sq); }
+		constexpr void flip(int sq){ bits ^= uint64_t(1) << sq; }
+		constexpr void clear(void){ bits = 0; }
+
+		constexpr bool any(void) const { return bits != 0; }
+		constexpr bool none(void) const { return bits == 0; }
+		constexpr explicit operator bool(void) const { return bits != 0; }
+		// mais de um bit ligado, sem contar
+		constexpr bool more_than_one(void) const { return bits & (bits - 1); }
+
+		int popcount(void) const { return __builtin_popcountll(bits); }
+		// os três seguintes não estão definidos para um tabuleiro vazio
+		int lsb(void) const { return __builtin_ctzll(bits); }
+		int msb(void) const { return 63 ^ __builtin_clzll(bits); }
+		int pop_lsb(void){
+			int sq = lsb();
+			bits &= bits - 1;
+			return sq;
+		}
+
+		constexpr BitBoard operator&(BitBoard o) const { return BitBoard(bits & o.bits); }
+		constexpr BitBoard operator|(BitBoard o) const { return BitBoard(bits | o.bits); }
+		constexpr BitBoard operator^(BitBoard o) const { return BitBoard(bits ^ o.bits); }
+		constexpr BitBoard operator~(void) const { return BitBoard(~bits); }
+		constexpr BitBoard operator<<(int n) const { return BitBoard(bits << n); }
+		constexpr BitBoard operator>>(int n) const { return BitBoard(bits >> n); }
+		constexpr BitBoard &operator&=(BitBoard o){ bits &= o.bits; return *this; }
+		constexpr BitBoard &operator|=(BitBoard o){ bits |= o.bits; return *this; }
+		constexpr BitBoard &operator^=(BitBoard o){ bits ^= o.bits; return *this; }
+		constexpr bool operator==(BitBoard o) const { return bits == o.bits; }
+		constexpr bool operator!=(BitBoard o) const { return bits != o.bits; }
 
+		// deslocamentos de um quadrado, sem dar a volta entre colunas a e h
+		constexpr BitBoard north(void) const { return BitBoard(bits << 8); }
+		constexpr BitBoard south(void) const { return BitBoard(bits >> 8); }
+		constexpr BitBoard east(void) const { return BitBoard((bits << 1) & ~0x0101010101010101ULL); }
+		constexpr BitBoard west(void) const { return BitBoard((bits >> 1) & ~0x8080808080808080ULL); }
+		constexpr BitBoard north_east(void) const { return BitBoard((bits << 9) & ~0x0101010101010101ULL); }
+		constexpr BitBoard north_west(void) const { return BitBoard((bits << 7) & ~0x8080808080808080ULL); }
+		constexpr BitBoard south_east(void) const { return BitBoard((bits >> 7) & ~0x0101010101010101ULL); }
+		constexpr BitBoard south_west(void) const { return BitBoard((bits >> 9) & ~0x8080808080808080ULL); }
+
+		// extrai os bits de mask para os bits baixos / deposita-os de volta
+		uint64_t pext(BitBoard mask) const {
+			#if BITBOARD_PEXT
+			return _pext_u64(bits, mask.bits);
+			#else
+			uint64_t r = 0, m = mask.bits;
+			for(uint64_t bb = 1; m; bb += bb){
+				if(bits & m & -m){
+					r |= bb;
+				}
+				m &= m - 1;
+			}
+			return r;
+			#endif
+		}
+		static BitBoard pdep(uint64_t src, BitBoard mask){
+			#if BITBOARD_PEXT
+			return BitBoard(_pdep_u64(src, mask.bits));
+			#else
+			uint64_t r = 0, m = mask.bits;
+			for(uint64_t bb = 1; m; bb += bb){
+				if(src & bb){
+					r |= m & -m;
+				}
+				m &= m - 1;
+			}
+			return BitBoard(r);
+			#endif
+		}
+
+		// for(int sq : bb) percorre os quadrados ligados, do menor para o maior
+		class Iterator {
+			uint64_t b;
+			public:
+				constexpr explicit Iterator(uint64_t v): b{v} {}
+				int operator*(void) const { return __builtin_ctzll(b); }
+				constexpr Iterator &operator++(void){ b &= b - 1; return *this; }
+				constexpr bool operator!=(const Iterator &o) const { return b != o.b; }
+		};
+		constexpr Iterator begin(void) const { return Iterator(bits); }
+		constexpr Iterator end(void) const { return Iterator(0); }
 };
 
-#endif // BITBOARD_HPP
+constexpr BitBoard EMPTY_BB { 0 };
+constexpr BitBoard FULL_BB { ~uint64_t(0) };
+
+constexpr BitBoard FILE_A_BB { 0x0101010101010101ULL };
+constexpr BitBoard FILE_B_BB { FILE_A_BB << 1 };
+constexpr BitBoard FILE_C_BB { FILE_A_BB << 2 };
+constexpr BitBoard FILE_D_BB { FILE_A_BB << 3 };
+constexpr BitBoard FILE_E_BB { FILE_A_BB << 4 };
+constexpr BitBoard FILE_F_BB { FILE_A_BB << 5 };
+constexpr BitBoard FILE_G_BB { FILE_A_BB << 6 };
+constexpr BitBoard FILE_H_BB { FILE_A_BB << 7 };
 
+constexpr BitBoard RANK_1_BB { 0xFFULL };
+constexpr BitBoard RANK_2_BB { RANK_1_BB << 8 };
+constexpr BitBoard RANK_3_BB { RANK_1_BB << 16 };
+constexpr BitBoard RANK_4_BB { RANK_1_BB << 24 };
+constexpr BitBoard RANK_5_BB { RANK_1_BB << 32 };
+constexpr BitBoard RANK_6_BB { RANK_1_BB << 40 };
+constexpr BitBoard RANK_7_BB { RANK_1_BB << 48 };
+constexpr BitBoard RANK_8_BB { RANK_1_BB << 56 };
+
+constexpr BitBoard LIGHT_SQUARES_BB { 0x55AA55AA55AA55AAULL };
+constexpr BitBoard DARK_SQUARES_BB { ~LIGHT_SQUARES_BB };
+
+constexpr BitBoard file_bb(int file){ return FILE_A_BB << file; }
+constexpr BitBoard rank_bb(int rank){ return RANK_1_BB << (8*rank); }
+
+#endif // BITBOARD_HPP
@@ -0,0 +1,50 @@
+#ifndef BOOK_HPP
+#define BOOK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "chess.hpp"
+#include "mappedfile.hpp"
+
+namespace chess {
+
+	// Livro de aberturas no formato Polyglot (.bin): entradas de 16 bytes big-endian
+	// ordenadas pela chave (uint64 chave, uint16 jogada, uint16 peso, uint32 aprendizagem).
+	// O ficheiro fica mapeado e cada consulta é uma pesquisa binária nele: nada se lê
+	// no arranque e nada fica copiado em memória.
+	//
+	// A chave Polyglot não é a nossa Zobrist: usa as 781 constantes fixas da
+	// especificação (Random64, em book.cpp). A posição inicial dá POLYGLOT_START_KEY.
+
+	constexpr int POLYGLOT_RANDOM_N { 781 };
+	constexpr uint64_t POLYGLOT_START_KEY { 0x463B96181691FC9CULL };
+	constexpr int BOOK_MAX_MOVES { 64 };
+
+	uint64_t polyglot_key(const Position &pos);
+
+	struct BookMove {
+		Move move;
+		int weight;
+	};
+
+	class Book {
+		MappedFile file;
+		const uint8_t *entries;
+		size_t count;
+		uint64_t rng;
+
+		public:
+		explicit Book(const char *path, uint64_t seed = 1);
+
+		// aberto e com um número inteiro de entradas
+		bool is_open(void) const { return this->entries != nullptr; }
+		size_t size(void) const { return this->count; }
+
+		// jogadas legais do livro para pos (no máximo max), pela ordem do ficheiro
+		int moves(const Position &pos, BookMove *out, int max) const;
+		// uma das jogadas, com probabilidade proporcional ao peso; NO_MOVE se não houver
+		Move probe(const Position &pos);
+	};
+}
+
+#endif // BOOK_HPP
@@ -1,113 +1,874 @@
 #include <cstdlib>
 #include <cassert>
-#include <algorithm> // chess::Position::setup_from_string
+#include <cstdio> // chess::test; printf
+#include <cstring>
+#include <unistd.h> // chess::test; close, unlink
 #include "chess.hpp"
+#include "attacks.hpp"
+#include "book.hpp"
+#include "pack.hpp"
+#include "pawns.hpp"
+#include "pgn.hpp"
+#include "psqt.hpp"
 
 namespace chess {
-	PieceColor Position::get_piece_color(Square sq){
-		if(this->byColorBB[PIECE_WHITE][sq]){
-			return PIECE_WHITE;
-		} 
-		if(this->byColorBB[PIECE_BLACK][sq]){
-			return PIECE_BLACK;
-		} 
-		return PIECE_COLORLESS;
+	PieceColor Position::get_piece_color(Square sq) const {
+		Piece p = this->board[sq];
+		return p == PIECE_NULL ? PIECE_COLORLESS : piece_color(p);
 	}
 
-	PieceType Position::get_piece_type(Square sq){
-		for(int i = 0; i < PIECE_N_TYPES; i++){
-			if(this->byTypeBB[i][sq]){
-				return PieceType(i);
-			}
-		}
-		return PIECE_TYPELESS;
+	PieceType Position::get_piece_type(Square sq) const {
+		Piece p = this->board[sq];
+		return p == PIECE_NULL ? PIECE_TYPELESS : piece_type(p);
 	}
 
-	Piece Position::get_piece(Square sq){
-		if(!this->occupiedBB[sq]){
-			return PIECE_NULL;
+	void Position::put_piece(Square sq, Piece p){
+		BitBoard b { BitBoard::square(sq) };
+		this->occupiedBB |= b;
+		this->byTypeBB[piece_type(p)] |= b;
+		this->byColorBB[piece_color(p)] |= b;
+		this->board[sq] = p;
+		this->key ^= zobrist_piece(p, sq);
+		if(piece_type(p) == PIECE_PAWN){
+			this->pawnKey ^= zobrist_piece(p, sq);
 		}
-		return piece_new(this->get_piece_type(sq), this->get_piece_color(sq));
+		this->psq += PSQ[p][sq];
+		this->phase += PHASE_WEIGHT[piece_type(p)];
 	}
 
-	void Position::empty_square(Square sq){
-		this->occupiedBB[sq] = false;
+	void Position::remove_piece(Square sq, Piece p){
+		BitBoard b { BitBoard::square(sq) };
+		this->occupiedBB ^= b;
+		this->byTypeBB[piece_type(p)] ^= b;
+		this->byColorBB[piece_color(p)] ^= b;
+		this->board[sq] = PIECE_NULL;
+		this->key ^= zobrist_piece(p, sq);
+		if(piece_type(p) == PIECE_PAWN){
+			this->pawnKey ^= zobrist_piece(p, sq);
+		}
+		this->psq -= PSQ[p][sq];
+		this->phase -= PHASE_WEIGHT[piece_type(p)];
+	}
 
-		int i;
-		for(i = 0; i < PIECE_N_TYPES; i++){
-			this->byTypeBB[i] &= this->occupiedBB;
+	void Position::move_piece(Square src, Square dst, Piece p){
+		BitBoard b { BitBoard::square(src) | BitBoard::square(dst) };
+		this->occupiedBB ^= b;
+		this->byTypeBB[piece_type(p)] ^= b;
+		this->byColorBB[piece_color(p)] ^= b;
+		this->board[src] = PIECE_NULL;
+		this->board[dst] = p;
+		this->key ^= zobrist_piece(p, src) ^ zobrist_piece(p, dst);
+		if(piece_type(p) == PIECE_PAWN){
+			this->pawnKey ^= zobrist_piece(p, src) ^ zobrist_piece(p, dst);
 		}
-		for(i = 0; i < PIECE_N_COLORS; i++){
-			this->byColorBB[i] &= this->occupiedBB;
+		this->psq += PSQ[p][dst] - PSQ[p][src];
+	}
+
+	void Position::empty_square(Square sq){
+		Piece p = this->get_piece(sq);
+		if(p != PIECE_NULL){
+			this->remove_piece(sq, p);
 		}
 	}
 
 	void Position::set_piece(Square sq, Piece p){
-		if(p == PIECE_NULL){
-			this->empty_square(sq);
-		} else {
-			this->occupiedBB[sq] = true;
+		this->empty_square(sq);
+		if(p != PIECE_NULL){
+			this->put_piece(sq, p);
+		}
+	}
 
-			PieceType t = piece_type(p);
-			PieceColor c = piece_color(p);
+	static CastleRight castle_rights_at_home(const Position &pos);
 
-			this->byTypeBB[t][sq] = true;
-			this->byColorBB[c][sq] = true;
+	// os roques cujo rei e torre ainda estão nas casas iniciais
+	static CastleRight castle_rights_at_home(const Position &pos){
+		const Piece home[4][2] { {PIECE_WKING, PIECE_WROOK}, {PIECE_WKING, PIECE_WROOK},
+		                         {PIECE_BKING, PIECE_BROOK}, {PIECE_BKING, PIECE_BROOK} };
+		const Square homeSq[4][2] { {E1, H1}, {E1, A1}, {E8, H8}, {E8, A8} };
+		const CastleRight rights[4] { CASTLE_WKING, CASTLE_WQUEEN, CASTLE_BKING, CASTLE_BQUEEN };
+		CastleRight cr = CASTLE_NONE;
+		for(int i = 0; i < 4; i++){
+			if(pos.get_piece(homeSq[i][0]) == home[i][0] && pos.get_piece(homeSq[i][1]) == home[i][1]){
+				cr = cr | rights[i];
+			}
 		}
+		return cr;
 	}
 
 	Position Position::from_string(char *str){
 		Position pos;
 		for(int i = 0; i < SQUARE_COUNT; i++){
-			char c = str[i];
-			if(!std::count(PIECE_CHAR.begin(), PIECE_CHAR.end(), c)){
-				continue;
-			}
 			Piece p = piece_from_char(str[i]);
-			pos.set_piece(Square(i), p);
+			if(p != PIECE_NULL){
+				pos.put_piece(Square(i), p);
+			}
 		} 
+
+		// sem mais informação, há direito de roque se rei e torre estão nas casas iniciais
+		pos.castleRights = castle_rights_at_home(pos);
+		pos.key = pos.compute_key();
 		return pos;
 	}
 	
-	bool Position::is_normal_legal(Move m){
-		assert(move_type(m) == MOVE_NORMAL);
+	// O que cada carácter do primeiro campo da FEN faz: escreve `piece` a partir da casa
+	// atual e avança `advance` casas ('/' não avança, um dígito avança sem peça).
+	// Na FEN as brancas são maiúsculas; aqui são minúsculas.
+	struct FenBoardChar {
+		uint8_t piece;
+		uint8_t advance;
+		uint8_t slash;
+		uint8_t invalid;
+	};
+
+	constexpr std::array<FenBoardChar, 128> FEN_BOARD = []{
+		std::array<FenBoardChar, 128> t {};
+		for(FenBoardChar &f : t){
+			f = FenBoardChar{ PIECE_NULL, 0, 0, 1 };
+		}
+		for(int i = 0; i < PIECE_N; i++){
+			t[PIECE_CHAR[i] ^ 0x20] = FenBoardChar{ uint8_t(PIECE_LIST[i]), 1, 0, 0 };
+		}
+		for(int d = 1; d <= 8; d++){
+			t['0' + d] = FenBoardChar{ PIECE_NULL, uint8_t(d), 0, 0 };
+		}
+		t['/'] = FenBoardChar{ PIECE_NULL, 0, 1, 0 };
+		return t;
+	}();
+
+	constexpr int FEN_COUNTER_MAX { 1 << 20 };
+	constexpr uint64_t FEN_BACK_RANKS { 0xFF000000000000FFULL }; // onde não pode haver peões
+
+	// um bit por byte de w igual a v (byte i -> bit i), sem ramos; w lido em little-endian
+	inline unsigned bytes_equal_mask(uint64_t w, uint8_t v){
+		constexpr uint64_t LOW7 { 0x7F7F7F7F7F7F7F7FULL };
+		uint64_t x = w ^ (0x0101010101010101ULL * v);
+		uint64_t zero = ~(((x & LOW7) + LOW7) | x | LOW7); // 0x80 nos bytes iguais
+		return unsigned(((zero >> 7) * 0x0102040810204080ULL) >> 56);
+	}
+
+	static const char *read_counter(const char *c, const char *end, int &v);
+	static char *write_counter(char *c, int v);
+
+	// contador depois de um espaço; nullptr (e v intacto) se não houver
+	static const char *read_counter(const char *c, const char *end, int &v){
+		if(c < end && *c == ' '){
+			c++;
+		}
+		if(c == end || unsigned(*c - '0') > 9){
+			return nullptr;
+		}
+		int n = 0;
+		for(; c < end && unsigned(*c - '0') <= 9; c++){
+			n = n < FEN_COUNTER_MAX ? n * 10 + (*c - '0') : n;
+		}
+		v = n;
+		return c;
+	}
+
+	static char *write_counter(char *c, int v){
+		char digits[8];
+		int n = 0;
+		do {
+			digits[n++] = char('0' + v % 10);
+			v /= 10;
+		} while(v && n < 8);
+		while(n){
+			*c++ = digits[--n];
+		}
+		return c;
+	}
+
+	bool Position::from_fen(const char *fen, Position &pos){
+		return from_fen(fen, fen + strlen(fen), pos) != nullptr;
+	}
+
+	const char *Position::from_fen(const char *fen, const char *end, Position &pos){
+		pos = Position();
+		const char *c = fen;
+
+		// 1.º: o tabuleiro pela ordem da FEN (a8..h8, a7..h1), sem ramos por carácter.
+		// Cada carácter escreve 8 casas de uma vez; as que não são suas são reescritas
+		// pelos seguintes, e as de depois da última ficam na folga do fim.
+		uint8_t squares[SQUARE_COUNT + 8];
+		int i = 0, slashes = 0;
+		unsigned bad = 0;
+		for(; c < end && *c != ' '; c++){
+			unsigned char ch = *c;
+			const FenBoardChar &f = FEN_BOARD[ch & 0x7F];
+			memset(squares + i, f.piece, 8);
+			// cada '/' tem de fechar uma fila inteira
+			bad |= f.invalid | (ch >> 7) | (f.slash & (i != 8 * (slashes + 1)));
+			slashes += f.slash;
+			i += f.advance;
+			if(i > SQUARE_COUNT){
+				return nullptr;
+			}
+		}
+		// o espaço e a cor
+		if(bad || i != SQUARE_COUNT || slashes != 7 || end - c < 2){
+			return nullptr;
+		}
+
+		// 2.º: as casas ocupadas saem de 8 comparações (a fila da FEN k / 8 é a 8 - k / 8)
+		uint64_t ranks[8];
+		memcpy(ranks, squares, sizeof(ranks));
+		uint64_t occupied = 0;
+		for(int r = 0; r < 8; r++){
+			occupied |= uint64_t(bytes_equal_mask(ranks[r], PIECE_NULL) ^ 0xFF) << (8 * (7 - r));
+		}
+		Piece pieces[SQUARE_COUNT];
+		int n = 0;
+		for(int sq : BitBoard(occupied)){
+			pieces[n++] = Piece(squares[sq ^ 56]);
+		}
+		// mais de 32 peças não cabe no resto do programa (NNUE, formato de 32 bytes)
+		if(n > 32){
+			return nullptr;
+		}
+		pos.place_pieces(BitBoard(occupied), pieces);
+		if(pos.pieces(PIECE_WHITE, PIECE_KING).popcount() != 1 ||
+		   pos.pieces(PIECE_BLACK, PIECE_KING).popcount() != 1 ||
+		   (pos.pieces(PIECE_PAWN) & BitBoard(FEN_BACK_RANKS))){
+			return nullptr;
+		}
+
+		c++;
+		if(*c == 'w'){
+			pos.sideToMove = PIECE_WHITE;
+		} else if(*c == 'b'){
+			pos.sideToMove = PIECE_BLACK;
+		} else {
+			return nullptr;
+		}
+		c++;
+		// quem não joga não pode estar em xeque: a pesquisa capturaria o rei
+		if(pos.attackers_to(pos.king_square(~pos.sideToMove), pos.occupiedBB) & pos.byColorBB[pos.sideToMove]){
+			return nullptr;
+		}
+
+		if(c < end && *c == ' '){
+			c++;
+		}
+		for(; c < end && *c != ' '; c++){
+			switch(*c){
+				case 'K': pos.castleRights = pos.castleRights | CASTLE_WKING; break;
+				case 'Q': pos.castleRights = pos.castleRights | CASTLE_WQUEEN; break;
+				case 'k': pos.castleRights = pos.castleRights | CASTLE_BKING; break;
+				case 'q': pos.castleRights = pos.castleRights | CASTLE_BQUEEN; break;
+				case '-': break;
+				default: return nullptr;
+			}
+		}
+		// um direito sem o rei e a torre em casa moveria uma torre que não existe
+		pos.castleRights = pos.castleRights & castle_rights_at_home(pos);
+
+		if(c < end && *c == ' '){
+			c++;
+		}
+		if(end - c >= 2 && c[0] >= 'a' && c[0] <= 'h' && c[1] >= '1' && c[1] <= '8'){
+			// como em do_move, só conta se algum peão puder capturar; e tem de estar na
+			// 6.ª fila (3.ª com as pretas a jogar), vazia, com o peão que avançou à frente
+			Square ep = square_new(c[0] - 'a', c[1] - '1');
+			PieceColor us = pos.sideToMove;
+			Square pushed = Square(us == PIECE_WHITE ? ep - 8 : ep + 8);
+			if(square_rank(ep) == (us == PIECE_WHITE ? 5 : 2) && pos.get_piece(ep) == PIECE_NULL &&
+			   pos.get_piece(pushed) == piece_new(PIECE_PAWN, ~us) &&
+			   (PAWN_ATTACKS[~us][ep] & pos.pieces(us, PIECE_PAWN))){
+				pos.epSquare = ep;
+			}
+		}
+		for(; c < end && *c != ' '; c++){}
+
+		// contadores: há conjuntos de teste (EPD) que não os têm
+		int halfmove = 0, fullmove = 1;
+		const char *counters = read_counter(c, end, halfmove);
+		if(counters){
+			c = counters;
+			counters = read_counter(c, end, fullmove);
+			c = counters ? counters : c;
+		}
+		pos.rule50 = halfmove;
+		pos.gamePly = 2 * (fullmove > 1 ? fullmove - 1 : 0) + (pos.sideToMove == PIECE_BLACK);
+
+		pos.add_state_key();
+		return c;
+	}
+
+	// o mesmo que put_piece faria peça a peça, mas em variáveis locais
+	void Position::place_pieces(BitBoard occupied, const Piece *pieces){
+		std::array<BitBoard, PIECE_N_TYPES> byType {};
+		std::array<BitBoard, PIECE_N_COLORS> byColor {};
+		uint64_t k = 0, pk = 0;
+		Score s = 0;
+		int ph = 0;
+		for(int sq : occupied){
+			Piece p = *pieces++;
+			PieceType t = piece_type(p);
+			uint64_t z = zobrist_piece(p, Square(sq));
+			this->board[sq] = p;
+			byType[t].set(sq);
+			byColor[piece_color(p)].set(sq);
+			k ^= z;
+			pk ^= t == PIECE_PAWN ? z : 0;
+			s += PSQ[p][sq];
+			ph += PHASE_WEIGHT[t];
+		}
+		this->byTypeBB = byType;
+		this->byColorBB = byColor;
+		this->occupiedBB = occupied;
+		this->key = k;
+		this->pawnKey = pk;
+		this->psq = s;
+		this->phase = ph;
+	}
+
+	void Position::add_state_key(void){
+		this->key ^= ZOBRIST.castle[this->castleRights];
+		if(this->epSquare != SQUARE_NONE){
+			this->key ^= ZOBRIST.epFile[square_file(this->epSquare)];
+		}
+		if(this->sideToMove == PIECE_BLACK){
+			this->key ^= ZOBRIST.side;
+		}
+	}
+
+	int Position::to_fen(char (&buf)[FEN_MAX]) const {
+		char *c = buf;
+		for(int rank = 7; rank >= 0; rank--){
+			int empty = 0;
+			for(int file = 0; file < 8; file++){
+				Piece p = this->board[square_new(file, rank)];
+				if(p == PIECE_NULL){
+					empty++;
+					continue;
+				}
+				if(empty){
+					*c++ = char('0' + empty);
+					empty = 0;
+				}
+				*c++ = char(piece_char(p) ^ 0x20);
+			}
+			if(empty){
+				*c++ = char('0' + empty);
+			}
+			*c++ = rank ? '/' : ' ';
+		}
 
+		*c++ = this->sideToMove == PIECE_WHITE ? 'w' : 'b';
+		*c++ = ' ';
+		if(this->castleRights == CASTLE_NONE){
+			*c++ = '-';
+		}
+		const CastleRight rights[4] { CASTLE_WKING, CASTLE_WQUEEN, CASTLE_BKING, CASTLE_BQUEEN };
+		for(int i = 0; i < 4; i++){
+			if(this->castleRights & rights[i]){
+				*c++ = "KQkq"[i];
+			}
+		}
+		*c++ = ' ';
+		if(this->epSquare != SQUARE_NONE){
+			*c++ = SQUARE_NAME[this->epSquare][0];
+			*c++ = SQUARE_NAME[this->epSquare][1];
+		} else {
+			*c++ = '-';
+		}
+		*c++ = ' ';
+		c = write_counter(c, this->rule50);
+		*c++ = ' ';
+		c = write_counter(c, this->fullmove_number());
+		*c = '\0';
+		return int(c - buf);
+	}
+
+	uint64_t Position::compute_key(void) const {
+		uint64_t k = 0;
+		for(int sq : this->occupiedBB){
+			k ^= zobrist_piece(this->board[sq], Square(sq));
+		}
+		k ^= ZOBRIST.castle[this->castleRights];
+		if(this->epSquare != SQUARE_NONE){
+			k ^= ZOBRIST.epFile[square_file(this->epSquare)];
+		}
+		if(this->sideToMove == PIECE_BLACK){
+			k ^= ZOBRIST.side;
+		}
+		return k;
+	}
+
+	uint64_t Position::compute_pawn_key(void) const {
+		uint64_t k = 0;
+		for(int sq : this->byTypeBB[PIECE_PAWN]){
+			k ^= zobrist_piece(this->board[sq], Square(sq));
+		}
+		return k;
+	}
+
+	Score Position::compute_psq(void) const {
+		Score s = 0;
+		for(int sq : this->occupiedBB){
+			s += PSQ[this->board[sq]][sq];
+		}
+		return s;
+	}
+
+	int Position::compute_phase(void) const {
+		int ph = 0;
+		for(int sq : this->occupiedBB){
+			ph += PHASE_WEIGHT[piece_type(this->board[sq])];
+		}
+		return ph;
+	}
+
+	BitBoard Position::attackers_to(Square sq, BitBoard occupied) const {
+		return (PAWN_ATTACKS[PIECE_BLACK][sq] & this->pieces(PIECE_WHITE, PIECE_PAWN)) |
+		       (PAWN_ATTACKS[PIECE_WHITE][sq] & this->pieces(PIECE_BLACK, PIECE_PAWN)) |
+		       (KNIGHT_ATTACKS[sq] & this->pieces(PIECE_KNIGHT)) |
+		       (KING_ATTACKS[sq] & this->pieces(PIECE_KING)) |
+		       (bishop_attacks(sq, occupied) & (this->pieces(PIECE_BISHOP) | this->pieces(PIECE_QUEEN))) |
+		       (rook_attacks(sq, occupied) & (this->pieces(PIECE_ROOK) | this->pieces(PIECE_QUEEN)));
+	}
+
+	BitBoard Position::pinned_pieces(PieceColor c) const {
+		Square ksq = this->king_square(c);
+		BitBoard them = this->byColorBB[~c];
+		BitBoard snipers = (rook_attacks(ksq, EMPTY_BB) & (this->pieces(PIECE_ROOK) | this->pieces(PIECE_QUEEN)) & them) |
+		                   (bishop_attacks(ksq, EMPTY_BB) & (this->pieces(PIECE_BISHOP) | this->pieces(PIECE_QUEEN)) & them);
+		BitBoard pinned;
+		for(int s : snipers){
+			BitBoard b = BETWEEN_BB[ksq][s] & this->occupiedBB;
+			if(b && !b.more_than_one()){
+				pinned |= b & this->byColorBB[c];
+			}
+		}
+		return pinned;
+	}
+
+	static void push_moves(MoveList &list, Square src, BitBoard targets){
+		for(int dst : targets){
+			list.push(move_new(MOVE_FLAG_NORMAL, src, Square(dst)));
+		}
+	}
+
+	static void push_promotions(MoveList &list, Square src, Square dst){
+		list.push(move_new_promotion(src, dst, PIECE_QUEEN));
+		list.push(move_new_promotion(src, dst, PIECE_ROOK));
+		list.push(move_new_promotion(src, dst, PIECE_BISHOP));
+		list.push(move_new_promotion(src, dst, PIECE_KNIGHT));
+	}
+
+	// Jogadas dos peões em `pawns`, só com destino em `mask`.
+	// Todos os peões andam para o mesmo lado, por isso faz-se tudo por conjuntos.
+	static void gen_pawn_moves(const Position &pos, MoveList &list, BitBoard pawns, BitBoard mask, GenType type){
+		PieceColor us = pos.side_to_move();
+		BitBoard empty = ~pos.pieces();
+		BitBoard enemies = pos.pieces(~us);
+		BitBoard lastRank = us == PIECE_WHITE ? RANK_8_BB : RANK_1_BB;
+		BitBoard thirdRank = us == PIECE_WHITE ? RANK_3_BB : RANK_6_BB;
+		int up = us == PIECE_WHITE ? 8 : -8;
+
+		BitBoard push1 = (us == PIECE_WHITE ? pawns.north() : pawns.south()) & empty;
+		BitBoard push2 = (us == PIECE_WHITE ? (push1 & thirdRank).north() : (push1 & thirdRank).south()) & empty;
+		BitBoard capW = (us == PIECE_WHITE ? pawns.north_west() : pawns.south_west()) & enemies & mask;
+		BitBoard capE = (us == PIECE_WHITE ? pawns.north_east() : pawns.south_east()) & enemies & mask;
+		int dW = us == PIECE_WHITE ? 7 : -9;
+		int dE = us == PIECE_WHITE ? 9 : -7;
+		push1 &= mask;
+		push2 &= mask;
+
+		if(type != GEN_QUIETS){
+			for(int dst : push1 & lastRank){
+				push_promotions(list, Square(dst - up), Square(dst));
+			}
+			for(int dst : capW & lastRank){
+				push_promotions(list, Square(dst - dW), Square(dst));
+			}
+			for(int dst : capE & lastRank){
+				push_promotions(list, Square(dst - dE), Square(dst));
+			}
+			for(int dst : capW & ~lastRank){
+				list.push(move_new(MOVE_FLAG_NORMAL, Square(dst - dW), Square(dst)));
+			}
+			for(int dst : capE & ~lastRank){
+				list.push(move_new(MOVE_FLAG_NORMAL, Square(dst - dE), Square(dst)));
+			}
+		}
+		if(type != GEN_CAPTURES){
+			for(int dst : push1 & ~lastRank){
+				list.push(move_new(MOVE_FLAG_NORMAL, Square(dst - up), Square(dst)));
+			}
+			for(int dst : push2){
+				list.push(move_new(MOVE_FLAG_DOUBLE_PUSH, Square(dst - 2*up), Square(dst)));
+			}
+		}
+	}
+
+	void Position::generate_legal(MoveList &list, GenType type) const {
+		PieceColor us = this->sideToMove;
+		PieceColor them = ~us;
+		BitBoard occ = this->occupiedBB;
+		BitBoard ours = this->byColorBB[us];
+		BitBoard enemies = this->byColorBB[them];
+		Square ksq = this->king_square(us);
+		BitBoard checkers = this->attackers_to(ksq, occ) & enemies;
+
+		BitBoard targets;
+		if(type != GEN_QUIETS){
+			targets |= enemies;
+		}
+		if(type != GEN_CAPTURES){
+			targets |= ~occ;
+		}
+
+		// rei: basta que o destino não fique atacado com o rei já fora da origem
+		BitBoard occNoKing = occ ^ BitBoard::square(ksq);
+		for(int dst : KING_ATTACKS[ksq] & targets){
+			if((this->attackers_to(Square(dst), occNoKing) & enemies).none()){
+				list.push(move_new(MOVE_FLAG_NORMAL, ksq, Square(dst)));
+			}
+		}
+
+		if(checkers.more_than_one()){
+			return;
+		}
+
+		// com xeque, as outras peças só podem capturar o atacante ou interpor-se
+		BitBoard checkMask = checkers ? BETWEEN_BB[ksq][checkers.lsb()] | checkers : FULL_BB;
+		BitBoard pinned = this->pinned_pieces(us);
+		targets &= checkMask;
+
+		for(int src : this->pieces(us, PIECE_KNIGHT) & ~pinned){
+			push_moves(list, Square(src), KNIGHT_ATTACKS[src] & targets);
+		}
+		for(int src : (this->pieces(PIECE_BISHOP) | this->pieces(PIECE_QUEEN)) & ours){
+			BitBoard b = bishop_attacks(Square(src), occ) & targets;
+			if(pinned.test(src)){
+				b &= LINE_BB[ksq][src];
+			}
+			push_moves(list, Square(src), b);
+		}
+		for(int src : (this->pieces(PIECE_ROOK) | this->pieces(PIECE_QUEEN)) & ours){
+			BitBoard b = rook_attacks(Square(src), occ) & targets;
+			if(pinned.test(src)){
+				b &= LINE_BB[ksq][src];
+			}
+			push_moves(list, Square(src), b);
+		}
+
+		BitBoard pawns = this->pieces(us, PIECE_PAWN);
+		gen_pawn_moves(*this, list, pawns & ~pinned, checkMask, type);
+		for(int src : pawns & pinned){
+			gen_pawn_moves(*this, list, BitBoard::square(src), checkMask & LINE_BB[ksq][src], type);
+		}
+
+		// en passant: raro, verifica-se diretamente removendo os dois peões
+		if(this->epSquare != SQUARE_NONE && type != GEN_QUIETS){
+			Square capSq = Square(this->epSquare + (us == PIECE_WHITE ? -8 : 8));
+			for(int src : PAWN_ATTACKS[them][this->epSquare] & pawns){
+				BitBoard after = (occ ^ BitBoard::square(src) ^ BitBoard::square(capSq)) | BitBoard::square(this->epSquare);
+				BitBoard attackers = this->attackers_to(ksq, after) & enemies & ~BitBoard::square(capSq);
+				if(attackers.none()){
+					list.push(move_new(MOVE_FLAG_EN_PASSANT, Square(src), this->epSquare));
+				}
+			}
+		}
+
+		if(checkers || type == GEN_CAPTURES){
+			return;
+		}
+		int base = us == PIECE_WHITE ? 0 : 56;
+		if((this->castleRights & castle_kingside(us)) &&
+		   (BETWEEN_BB[base + E1][base + H1] & occ).none() &&
+		   (this->attackers_to(Square(base + F1), occ) & enemies).none() &&
+		   (this->attackers_to(Square(base + G1), occ) & enemies).none()){
+			list.push(move_new(MOVE_FLAG_CASTLE, ksq, Square(base + G1)));
+		}
+		if((this->castleRights & castle_queenside(us)) &&
+		   (BETWEEN_BB[base + E1][base + A1] & occ).none() &&
+		   (this->attackers_to(Square(base + D1), occ) & enemies).none() &&
+		   (this->attackers_to(Square(base + C1), occ) & enemies).none()){
+			list.push(move_new(MOVE_FLAG_CASTLE, ksq, Square(base + C1)));
+		}
+	}
+
+	Move Position::find_move(Square src, Square dst) const {
+		MoveList list;
+		this->generate_legal(list);
+		for(Move m : list){
+			if(move_src(m) == src && move_dst(m) == dst &&
+			   (move_type(m) != MOVE_PROMOTION || move_promotion(m) == PIECE_QUEEN)){
+				return m;
+			}
+		}
+		return NO_MOVE;
+	}
+
+	// direitos que sobrevivem a uma jogada que parta ou chegue a cada quadrado
+	static constexpr std::array<int, SQUARE_COUNT> CASTLE_KEEP = []{
+		std::array<int, SQUARE_COUNT> t {};
+		for(int i = 0; i < SQUARE_COUNT; i++){
+			t[i] = CASTLE_BOTH;
+		}
+		t[A1] &= ~CASTLE_WQUEEN;
+		t[H1] &= ~CASTLE_WKING;
+		t[E1] &= ~CASTLE_WHITE;
+		t[A8] &= ~CASTLE_BQUEEN;
+		t[H8] &= ~CASTLE_BKING;
+		t[E8] &= ~CASTLE_BLACK;
+		return t;
+	}();
+
+	uint64_t Position::key_after(Move m) const {
 		Square src = move_src(m);
 		Square dst = move_dst(m);
-		PieceColor cSrc = this->get_piece_color(src);
-		PieceColor cDst = this->get_piece_color(dst);
-		if((src == dst) ||
-		   (cSrc == cDst) ||
-		   (cSrc == PIECE_COLORLESS)) { // ou seja, quadrado vazio
-			return false;
+		Piece p = this->board[src];
+		Piece captured = this->board[dst];
+		uint64_t k = this->key ^ ZOBRIST.side ^ zobrist_piece(p, src) ^ zobrist_piece(p, dst);
+
+		if(captured != PIECE_NULL){
+			k ^= zobrist_piece(captured, dst);
+		}
+		if(this->epSquare != SQUARE_NONE){
+			k ^= ZOBRIST.epFile[square_file(this->epSquare)];
 		}
+		int cr = this->castleRights & CASTLE_KEEP[src] & CASTLE_KEEP[dst];
+		return k ^ ZOBRIST.castle[this->castleRights] ^ ZOBRIST.castle[cr];
 	}
 
-	void Position::apply_normal(Move m){
-		assert(move_type(m) == MOVE_NORMAL);
+	void Position::do_move(Move m, StateInfo &st){
+		Square src = move_src(m);
+		Square dst = move_dst(m);
+		MoveType t = move_type(m);
+		PieceColor us = this->sideToMove;
+		PieceColor them = ~us;
+		Piece p = this->get_piece(src);
+		Square capSq = t == MOVE_EN_PASSANT ? Square(dst ^ 8) : dst;
+
+		st.key = this->key;
+		st.castleRights = this->castleRights;
+		st.epSquare = this->epSquare;
+		st.captured = this->get_piece(capSq);
+		st.rule50 = this->rule50;
+
+		this->rule50 = st.captured != PIECE_NULL || piece_type(p) == PIECE_PAWN ? 0 : this->rule50 + 1;
+		this->gamePly++;
+		if(st.captured != PIECE_NULL){
+			this->remove_piece(capSq, st.captured);
+		}
+		if(t == MOVE_CASTLE){
+			Square rsrc = square_new(dst > src ? 7 : 0, square_rank(src));
+			Square rdst = Square((src + dst) / 2);
+			this->move_piece(rsrc, rdst, piece_new(PIECE_ROOK, us));
+		}
+		this->move_piece(src, dst, p);
+		if(t == MOVE_PROMOTION){
+			this->remove_piece(dst, p);
+			this->put_piece(dst, piece_new(move_promotion(m), us));
+		}
+
+		// só se marca en passant quando há um peão que o possa fazer
+		if(this->epSquare != SQUARE_NONE){
+			this->key ^= ZOBRIST.epFile[square_file(this->epSquare)];
+			this->epSquare = SQUARE_NONE;
+		}
+		if(move_flag(m) == MOVE_FLAG_DOUBLE_PUSH){
+			Square ep = Square((src + dst) / 2);
+			if(PAWN_ATTACKS[us][ep] & this->pieces(them, PIECE_PAWN)){
+				this->epSquare = ep;
+				this->key ^= ZOBRIST.epFile[square_file(ep)];
+			}
+		}
+
+		CastleRight cr = CastleRight(this->castleRights & CASTLE_KEEP[src] & CASTLE_KEEP[dst]);
+		if(cr != this->castleRights){
+			this->key ^= ZOBRIST.castle[this->castleRights] ^ ZOBRIST.castle[cr];
+			this->castleRights = cr;
+		}
+		this->switch_side();
+
+		#ifdef CHESS_DEBUG
+		assert(this->key == this->compute_key() && this->pawnKey == this->compute_pawn_key());
+		assert(this->psq == this->compute_psq() && this->phase == this->compute_phase());
+		#endif
+	}
+
+	void Position::undo_move(Move m, const StateInfo &st){
+		this->switch_side();
 
 		Square src = move_src(m);
 		Square dst = move_dst(m);
-		Piece p1 = this->get_piece(src);
-		this->empty_square(src);
-		this->set_piece(dst, p1);
+		MoveType t = move_type(m);
+		PieceColor us = this->sideToMove;
+		Piece p = this->get_piece(dst);
+
+		if(t == MOVE_PROMOTION){
+			this->remove_piece(dst, p);
+			p = piece_new(PIECE_PAWN, us);
+			this->put_piece(dst, p);
+		}
+		this->move_piece(dst, src, p);
+		if(t == MOVE_CASTLE){
+			Square rsrc = square_new(dst > src ? 7 : 0, square_rank(src));
+			Square rdst = Square((src + dst) / 2);
+			this->move_piece(rdst, rsrc, piece_new(PIECE_ROOK, us));
+		}
+		if(st.captured != PIECE_NULL){
+			this->put_piece(t == MOVE_EN_PASSANT ? Square(dst ^ 8) : dst, st.captured);
+		}
+
+		// a chave volta inteira; as peças acima alteraram-na só de passagem
+		this->castleRights = st.castleRights;
+		this->epSquare = st.epSquare;
+		this->key = st.key;
+		this->rule50 = st.rule50;
+		this->gamePly--;
+
+		#ifdef CHESS_DEBUG
+		assert(this->key == this->compute_key() && this->pawnKey == this->compute_pawn_key());
+		assert(this->psq == this->compute_psq() && this->phase == this->compute_phase());
+		#endif
+	}
+
+	void Position::do_null_move(StateInfo &st){
+		st.key = this->key;
+		st.castleRights = this->castleRights;
+		st.epSquare = this->epSquare;
+		st.captured = PIECE_NULL;
+		st.rule50 = this->rule50;
+
+		this->rule50++;
+		this->gamePly++;
+		if(this->epSquare != SQUARE_NONE){
+			this->key ^= ZOBRIST.epFile[square_file(this->epSquare)];
+			this->epSquare = SQUARE_NONE;
+		}
+		this->switch_side();
+	}
+
+	void Position::undo_null_move(const StateInfo &st){
+		this->sideToMove = ~this->sideToMove;
+		this->epSquare = st.epSquare;
+		this->key = st.key;
+		this->rule50 = st.rule50;
+		this->gamePly--;
 	}
 
 	void Position::switch_side(void){
 		this->sideToMove = ~this->sideToMove;
+		this->key ^= ZOBRIST.side;
 	}
 	
-	bool Position::is_legal(Move m){
-		if(PieceColor(move_color(m))!=this->sideToMove){
+	// Troca estática sobre occupiedBB: cada lado recaptura com a peça menos valiosa
+	// e, ao tirá-la do tabuleiro, as peças deslizantes que estavam atrás (raios-X)
+	// passam a atacar. swap é o que quem está a perder ainda tem de recuperar.
+	bool Position::see_ge(Move m, int threshold) const {
+		if(move_type(m) != MOVE_NORMAL){
+			return 0 >= threshold;
+		}
+		Square src = move_src(m), dst = move_dst(m);
+		Piece victim = this->board[dst];
+
+		int swap = (victim == PIECE_NULL ? 0 : PIECE_VALUE[piece_type(victim)]) - threshold;
+		if(swap < 0){
 			return false;
 		}
-		switch(move_type(m)){
-			case MOVE_NORMAL:
-				return this->is_normal_legal(m);
+		swap = PIECE_VALUE[piece_type(this->board[src])] - swap;
+		if(swap <= 0){
+			return true;
+		}
+
+		BitBoard occ = this->occupiedBB ^ BitBoard::square(src) ^ BitBoard::square(dst);
+		BitBoard diagonal = this->byTypeBB[PIECE_BISHOP] | this->byTypeBB[PIECE_QUEEN];
+		BitBoard straight = this->byTypeBB[PIECE_ROOK] | this->byTypeBB[PIECE_QUEEN];
+		BitBoard attackers = this->attackers_to(dst, occ);
+		PieceColor stm = piece_color(this->board[src]);
+		bool res = true;
+
+		for(;;){
+			stm = ~stm;
+			attackers &= occ;
+			BitBoard stmAttackers = attackers & this->byColorBB[stm];
+			if(stmAttackers.none()){
 				break;
-			default:
+			}
+			res = !res;
+
+			int t = PIECE_PAWN;
+			while((stmAttackers & this->byTypeBB[t]).none()){
+				t++;
+			}
+			if(t == PIECE_KING){
+				// o rei só pode recapturar se o outro lado já não tiver atacantes
+				return (attackers & ~this->byColorBB[stm]).any() ? !res : res;
+			}
+
+			swap = PIECE_VALUE[t] - swap;
+			if(swap < int(res)){
+				break;
+			}
+			occ.reset((stmAttackers & this->byTypeBB[t]).lsb());
+			if(t == PIECE_PAWN || t == PIECE_BISHOP || t == PIECE_QUEEN){
+				attackers |= bishop_attacks(dst, occ) & diagonal;
+			}
+			if(t == PIECE_ROOK || t == PIECE_QUEEN){
+				attackers |= rook_attacks(dst, occ) & straight;
+			}
+		}
+		return res;
+	}
+
+	// Verifica uma jogada que não veio do gerador (tabela de transposição, killers...)
+	// sem gerar a lista toda. Os tipos raros vão ao gerador.
+	bool Position::is_legal(Move m) const {
+		PieceColor us = this->sideToMove;
+		if(move_type(m) != MOVE_NORMAL){
+			if(move_type(m) == MOVE_NONE){
+				return false;
+			}
+			MoveList list;
+			this->generate_legal(list, move_type(m) == MOVE_CASTLE ? GEN_QUIETS : GEN_CAPTURES);
+			return list.contains(m);
+		}
+
+		Square src = move_src(m), dst = move_dst(m);
+		Piece p = this->board[src];
+		if(p == PIECE_NULL || piece_color(p) != us || this->byColorBB[us].test(dst)){
+			return false;
+		}
+		bool doublePush = move_flag(m) == MOVE_FLAG_DOUBLE_PUSH;
+		if(doublePush && piece_type(p) != PIECE_PAWN){
+			return false;
+		}
+		BitBoard occ = this->occupiedBB;
+		BitBoard enemies = this->byColorBB[~us];
+		PieceType t = piece_type(p);
+		if(t == PIECE_PAWN){
+			int up = us == PIECE_WHITE ? 8 : -8;
+			if(rank_bb(us == PIECE_WHITE ? 7 : 0).test(dst)){
+				return false; // seria promoção
+			}
+			// o avanço de duas casas só é válido com a marca de MOVE_FLAG_DOUBLE_PUSH, e vice-versa
+			bool ok = doublePush ?
+			          dst == src + 2*up && square_rank(src) == (us == PIECE_WHITE ? 1 : 6) &&
+			          !occ.test(src + up) && !occ.test(dst) :
+			          (PAWN_ATTACKS[us][src].test(dst) && enemies.test(dst)) || (dst == src + up && !occ.test(dst));
+			if(!ok){
+				return false;
+			}
+		} else if(t == PIECE_KING){
+			return KING_ATTACKS[src].test(dst) &&
+			       (this->attackers_to(dst, occ ^ BitBoard::square(src)) & enemies).none();
+		} else if(!piece_attacks(t, src, occ).test(dst)){
+			return false;
+		}
+
+		Square ksq = this->king_square(us);
+		BitBoard checkers = this->attackers_to(ksq, occ) & enemies;
+		if(checkers){
+			if(checkers.more_than_one() || !(BETWEEN_BB[ksq][checkers.lsb()] | checkers).test(dst)){
 				return false;
+			}
 		}
+		return !this->pinned_pieces(us).test(src) || aligned(ksq, src, dst);
 	}
 
 	bool Position::make_move(Move m){
@@ -115,33 +876,44 @@ namespace chess {
 			return false;
 		}
 
-		this->switch_side();
-		
-		MoveType t = move_type(m);
-		switch(t){
-			case(MOVE_NORMAL):
-				this->apply_normal(m);
-				break;
-			default:
-				std::abort();
-				break;
-		}
+		StateInfo st;
+		this->do_move(m, st);
 
 		return true;
 	}
 
 	
 	bool Game::make_move(Move m){
-		Position cpy { this->currPosition.copy() };
+		if(!this->currPosition.is_legal(m)){
+			return false;
+		}
+
+		this->states.emplace_back();
+		this->currPosition.do_move(m, this->states.back());
+		this->moves.push_back(m);
+		return true;
+	}
 
-		if(!cpy.make_move(m)){
+	bool Game::undo_move(void){
+		if(this->moves.empty()){
 			return false;
 		}
 
-		this->currPosition = cpy;
+		this->currPosition.undo_move(this->moves.back(), this->states.back());
+		this->moves.pop_back();
+		this->states.pop_back();
 		return true;
 	}
 
+	void init(void){
+		static bool done = false;
+		if(done){
+			return;
+		}
+		done = true;
+		attacks_init();
+	}
+
 	void test(void){
 		assert(piece_from_char('p')==PIECE_WPAWN);
 		assert(piece_from_char('n')==PIECE_WKNIGHT);
@@ -181,7 +953,9 @@ namespace chess {
 		assert(piece_index(PIECE_BROOK)==9);
 		assert(piece_index(PIECE_BQUEEN)==10);
 		assert(piece_index(PIECE_BKING)==11);
-		assert(piece_index(PIECE_BKING)==11);
+		assert(piece_index(PIECE_NULL)==PIECE_N);
+		assert(piece_from_char(' ')==PIECE_NULL);
+		assert(piece_char(PIECE_NULL)==' ');
 
 		assert(piece_type(PIECE_WPAWN) == PIECE_PAWN);
 		assert(piece_type(PIECE_WKNIGHT) == PIECE_KNIGHT);
@@ -223,33 +997,218 @@ namespace chess {
 		assert(piece_new(PIECE_KING, PIECE_BLACK) == PIECE_BKING);
 
 
+		BitBoard bb { FILE_A_BB | RANK_8_BB };
+		assert(bb.popcount() == 15);
+		assert(bb.lsb() == A1 && bb.msb() == H8);
+		assert(bb.test(A8) && !bb.test(B7));
+		assert(FILE_H_BB.east().none() && FILE_A_BB.west().none());
+		assert(RANK_1_BB.north() == RANK_2_BB);
+		assert(bb.pext(RANK_8_BB) == 0xFF);
+		assert(BitBoard::pdep(0x3, FILE_A_BB) == (BitBoard::square(A1) | BitBoard::square(A2)));
+		int n = 0;
+		for(int sq : bb){
+			n += bb.test(sq);
+		}
+		assert(n == 15);
+		while(bb){
+			bb.pop_lsb();
+		}
+		assert(bb.none());
+
+		assert(rook_attacks(A1, EMPTY_BB).popcount() == 14);
+		assert(bishop_attacks(D4, EMPTY_BB).popcount() == 13);
+		bb = BitBoard::square(A4) | BitBoard::square(C1) | BitBoard::square(F6);
+		assert(rook_attacks(A1, bb) == (BitBoard::square(A2) | BitBoard::square(A3) | BitBoard::square(A4) |
+		                                BitBoard::square(B1) | BitBoard::square(C1)));
+		assert(bishop_attacks(D4, bb).test(F6) && !bishop_attacks(D4, bb).test(G7));
+		assert(queen_attacks(D4, bb) == (rook_attacks(D4, bb) | bishop_attacks(D4, bb)));
+
+		assert(KNIGHT_ATTACKS[A1] == (BitBoard::square(B3) | BitBoard::square(C2)));
+		assert(KING_ATTACKS[H8].popcount() == 3);
+		assert(PAWN_ATTACKS[PIECE_WHITE][E4] == (BitBoard::square(D5) | BitBoard::square(F5)));
+		assert(PAWN_ATTACKS[PIECE_BLACK][A5] == BitBoard::square(B4));
+		assert(BETWEEN_BB[A1][H8].popcount() == 6 && BETWEEN_BB[A1][H8] == BETWEEN_BB[H8][A1]);
+		assert(BETWEEN_BB[A1][B3].none() && BETWEEN_BB[E1][E2].none());
+		assert(LINE_BB[C3][E5] == LINE_BB[A1][H8] && LINE_BB[A1][B3].none());
+		assert(aligned(A1, D4, H8) && !aligned(A1, D4, H7));
+
+		Position start = Position::from_string(DEFAULT_POSITION);
+		MoveList all, captures, quiets;
+		start.generate_legal(all);
+		start.generate_legal(captures, GEN_CAPTURES);
+		start.generate_legal(quiets, GEN_QUIETS);
+		assert(all.size() == 20 && captures.size() == 0 && quiets.size() == 20);
+		assert(start.castle_rights() == CASTLE_BOTH);
+		Position fromFen;
+		assert(Position::from_fen(START_FEN, fromFen) && fromFen.get_key() == start.get_key());
+		assert(!Position::from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1", fromFen));
+		char name[6];
+		move_name(move_new_promotion(E7, F8, PIECE_KNIGHT), name);
+		assert(name[0] == 'e' && name[3] == '8' && name[4] == 'n' && name[5] == '\0');
+		assert(start.find_move(E2, E4) == move_new(MOVE_FLAG_DOUBLE_PUSH, E2, E4));
+		assert(start.find_move(E2, E3) == move_new(MOVE_FLAG_NORMAL, E2, E3));
+		assert(move_type(start.find_move(E2, E5)) == MOVE_NONE);
+		assert(move_promotion(move_new_promotion(B2, A1, PIECE_ROOK)) == PIECE_ROOK);
+		assert(sizeof(Move) == 2 && move_type(NO_MOVE) == MOVE_NONE);
+
+		assert(mg_value(make_score(-5, 7) + make_score(3, -20)) == -2);
+		assert(eg_value(make_score(-5, 7) + make_score(3, -20)) == -13);
+		assert(start.psq_score() == 0 && start.game_phase() == PHASE_MAX);
+
+		// estrutura de peões: sem peões pretos, todos os brancos são passados exceto o de trás dos dobrados
+		PawnTable pawnTable(1024);
+		assert(Position::from_fen("4k3/8/8/3P4/8/P7/P6P/4K3 w - - 0 1", fromFen));
+		assert(pawnTable.probe(fromFen).passed[PIECE_WHITE] == (fromFen.pieces(PIECE_WHITE, PIECE_PAWN) ^ BitBoard::square(A2)));
+		assert(pawnTable.probe(fromFen).passed[PIECE_BLACK].none());
+		assert(pawnTable.get_stats().probes == 2 && pawnTable.get_stats().hits == 1);
+
+		// troca estática: torre ganha um peão solto; cavalo por peão defendido perde 220
+		assert(Position::from_fen("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", fromFen));
+		assert(fromFen.see_ge(fromFen.find_move(E1, E5), 100) && !fromFen.see_ge(fromFen.find_move(E1, E5), 101));
+		assert(Position::from_fen("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", fromFen));
+		assert(fromFen.see_ge(fromFen.find_move(D3, E5), -220) && !fromFen.see_ge(fromFen.find_move(D3, E5), -219));
+
+		// is_legal tem de concordar com o gerador para qualquer par de quadrados
+		const char *legalFens[] = {
+			"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+			"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+			"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+			"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+		};
+		int mismatches = 0;
+		for(const char *f : legalFens){
+			mismatches += !Position::from_fen(f, fromFen);
+			all.clear();
+			fromFen.generate_legal(all);
+			for(int a = 0; a < SQUARE_COUNT; a++){
+				for(int b = 0; b < SQUARE_COUNT; b++){
+					for(MoveFlag flag : { MOVE_FLAG_NORMAL, MOVE_FLAG_DOUBLE_PUSH }){
+						Move m = move_new(flag, Square(a), Square(b));
+						mismatches += fromFen.is_legal(m) != all.contains(m);
+					}
+				}
+			}
+			for(Move m : all){
+				mismatches += !fromFen.is_legal(m);
+			}
+		}
+		assert(mismatches == 0);
+
+		// a FEN escrita é a lida, contadores incluídos
+		char fen[FEN_MAX];
+		for(const char *f : legalFens){
+			assert(Position::from_fen(f, fromFen));
+			assert(fromFen.to_fen(fen) == int(strlen(f)) && !strcmp(fen, f));
+			(void)f;
+		}
+		assert(start.to_fen(fen) > 0 && !strcmp(fen, START_FEN));
+		// e o formato de 32 bytes devolve a mesma FEN
+		PackedPosition packed;
+		char unpackedFen[FEN_MAX];
+		for(const char *f : legalFens){
+			Position unpacked;
+			assert(Position::from_fen(f, fromFen) && fromFen.pack(packed) && Position::unpack(packed, unpacked));
+			fromFen.to_fen(fen);
+			unpacked.to_fen(unpackedFen);
+			assert(!strcmp(fen, unpackedFen) && unpacked.get_key() == fromFen.get_key());
+			assert(unpacked.psq_score() == fromFen.psq_score() && unpacked.pawn_key() == fromFen.pawn_key());
+			(void)f;
+		}
+		(void)packed;
+		const char *epd = "4k3/8/8/8/8/8/8/4K2R w K - bm O-O;\n";
+		assert(Position::from_fen(epd, epd + strlen(epd), fromFen) == epd + 26);
+		(void)epd;
+		assert(fromFen.halfmove_clock() == 0 && fromFen.fullmove_number() == 1);
+		assert(Position::from_fen("4k3/8/8/8/8/8/8/4K2R b K - 7 42", fromFen) && fromFen.fullmove_number() == 42);
+		StateInfo st;
+		Move kingMove = fromFen.find_move(E8, E7);
+		fromFen.do_move(kingMove, st);
+		assert(fromFen.halfmove_clock() == 8 && fromFen.fullmove_number() == 43);
+		fromFen.undo_move(kingMove, st);
+		assert(fromFen.halfmove_clock() == 7 && fromFen.fullmove_number() == 42);
+		// direitos de roque sem rei e torre em casa caem; en passant só atrás do peão que avançou
+		assert(Position::from_fen("r3k2r/8/8/8/8/8/8/4K3 w KQkq - 0 1", fromFen) && fromFen.castle_rights() == CASTLE_BLACK);
+		assert(fromFen.get_key() == fromFen.compute_key());
+		assert(Position::from_fen("4k3/8/8/3pP3/8/8/8/4K3 w - d3 0 1", fromFen) && fromFen.ep_square() == SQUARE_NONE);
+		assert(Position::from_fen("4k3/8/8/4P3/8/8/8/4K3 w - d6 0 1", fromFen) && fromFen.ep_square() == SQUARE_NONE);
+		assert(Position::from_fen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", fromFen) && fromFen.ep_square() == D6);
+		assert(!Position::from_fen("4k2P/8/8/8/8/8/8/4K3 w - - 0 1", fromFen));
+		assert(!Position::from_fen("4k3/8/8/8/8/8/8/p3K3 b - - 0 1", fromFen));
+		assert(!Position::from_fen("4k3/8/8/8/8/8/8/4R1K1 w - - 0 1", fromFen));
+		assert(!Position::from_fen("qqqqkqqq/qqqqqqqq/qqqqqqqq/qqqqqqqq/QQQQQQQQ/QQQQQQQQ/QQQQQQQQ/QQQQKQQQ w - - 0 1", fromFen));
+		// chaves Polyglot: os exemplos da especificação, o segundo com roques e en passant
+		assert(polyglot_key(start) == POLYGLOT_START_KEY);
+		assert(Position::from_fen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", fromFen));
+		assert(polyglot_key(fromFen) == 0x22A48B5A8E47FF78ULL);
+
+		// SAN: desambiguação, capturas, en passant, promoções e roques
+		auto san = [](const Position &pos, const char *text){ return san_to_move(pos, text, text + strlen(text)); };
+		assert(Position::from_fen("rnbqkb1r/ppp1pppp/5n2/3p4/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1", fromFen));
+		assert(san(fromFen, "Nbd7") == fromFen.find_move(B8, D7) && san(fromFen, "Nfd7") == fromFen.find_move(F6, D7));
+		assert(san(fromFen, "Nc4") == NO_MOVE && san(fromFen, "Ke7") == NO_MOVE);
+		assert(Position::from_fen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", fromFen));
+		assert(san(fromFen, "exd6") == fromFen.find_move(E5, D6) && move_type(san(fromFen, "exd6")) == MOVE_EN_PASSANT);
+		assert(Position::from_fen("4k3/8/8/3p4/4P3/8/8/4K3 w - - 0 1", fromFen));
+		assert(san(fromFen, "exd5") == fromFen.find_move(E4, D5) && san(fromFen, "e5") == fromFen.find_move(E4, E5));
+		assert(san(fromFen, "exf5") == NO_MOVE);
+		assert(Position::from_fen("k7/4P3/8/8/8/8/8/4K3 w - - 0 1", fromFen));
+		assert(san(fromFen, "e8=Q+") == move_new_promotion(E7, E8, PIECE_QUEEN));
+		assert(san(fromFen, "e8Q") == move_new_promotion(E7, E8, PIECE_QUEEN));
+		assert(san(fromFen, "e8=N") == move_new_promotion(E7, E8, PIECE_KNIGHT) && san(fromFen, "e8") == NO_MOVE);
+		assert(Position::from_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", fromFen));
+		assert(san(fromFen, "O-O") == fromFen.find_move(E1, G1) && san(fromFen, "O-O-O") == fromFen.find_move(E1, C1));
+		assert(san(fromFen, "0-0") == fromFen.find_move(E1, G1) && san(fromFen, "0-0-0") == fromFen.find_move(E1, C1));
+		(void)san;
+
+		// e um PGN inteiro: roques com zeros (também colados ao número) e um jogo com uma jogada ilegal
+		const char *pgnText =
+			"[Event \"a\"]\n\n1. e4 e5 2. Nf3 Nf6 3. Bc4 Bc5 4. 0-0 0-0 0-1\n\n"
+			"[Event \"b\"]\n\n1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4.0-0 Nf6 5. d3 Bc5 6. Be3 0-0 1/2-1/2\n\n"
+			"[Event \"c\"]\n\n1. e4 e5 2. Ke3 *\n";
+		char pgnPath[] = "/tmp/xadrez-pgn-XXXXXX";
+		int fd = mkstemp(pgnPath);
+		bool written = fd >= 0 && write(fd, pgnText, strlen(pgnText)) == ssize_t(strlen(pgnText));
+		if(fd >= 0){
+			close(fd);
+		}
+		if(written){
+			ThreadPool pool(1);
+			int castles = 0;
+			PgnStats pgnStats = PgnFile(pgnPath).replay(pool, [&castles](int, const PgnGame &g){
+				for(int i = 0; i < g.moveCount; i++){
+					castles += move_type(g.moves[i]) == MOVE_CASTLE;
+				}
+			});
+			assert(pgnStats.games == 2 && pgnStats.moves == 8 + 12 && pgnStats.errors == 1 && castles == 4);
+			(void)pgnStats;
+		}
+		unlink(pgnPath);
+
+		Game game;
+		assert(game.make_move(start.find_move(E2, E4)));
+		assert(!game.make_move(start.find_move(D2, D4))); // não é a vez das brancas
+		assert(game.get_position().get_piece(E4) == PIECE_WPAWN);
+		assert(game.get_position().get_key() == game.get_position().compute_key());
+		assert(game.get_position().psq_score() == game.get_position().compute_psq());
+		assert(game.get_position().pawn_key() == game.get_position().compute_pawn_key());
+		assert(game.get_position().pawn_key() != start.pawn_key());
+		assert(game.get_position().get_key() != start.get_key());
+		assert(game.undo_move() && !game.undo_move());
+		assert(game.get_position().get_key() == start.get_key());
+		for(int i = 0; i < SQUARE_COUNT; i++){
+			assert(game.get_position().get_piece(Square(i)) == start.get_piece(Square(i)));
+		}
+
 		#define assert1(e) do { if(!(e)) { printf("src: %d dst: %d\n", i, k); assert((e)); } } while(0) 
 		for(int i = 0; i < 64; i++){
 			for(int k = 0; k < 64; k++){
-				Move m;
-				m = move_new(MOVE_NORMAL, MOVE_WHITE, Square(i), Square(k));
-				assert1(move_type(m) == MOVE_NORMAL);
-				assert1(move_color(m) == MOVE_WHITE);
-				assert1(move_src(m) == Square(i));
-				assert1(move_dst(m) == Square(k));
-
-				m = move_new(MOVE_NORMAL, MOVE_BLACK, Square(i), Square(k));
-				assert1(move_type(m) == MOVE_NORMAL);
-				assert1(move_color(m) == MOVE_BLACK);
-				assert1(move_src(m) == Square(i));
-				assert1(move_dst(m) == Square(k));
-
-				m = move_new(MOVE_NONE, MOVE_WHITE, Square(i), Square(k));
-				assert1(move_type(m) == MOVE_NONE);
-				assert1(move_color(m) == MOVE_WHITE);
-				assert1(move_src(m) == Square(i));
-				assert1(move_dst(m) == Square(k));
-
-				m = move_new(MOVE_NONE, MOVE_BLACK, Square(i), Square(k));
-				assert1(move_type(m) == MOVE_NONE);
-				assert1(move_color(m) == MOVE_BLACK);
-				assert1(move_src(m) == Square(i));
-				assert1(move_dst(m) == Square(k));
+				for(int f = 0; f < 16; f++){
+					Move m = move_new(MoveFlag(f), Square(i), Square(k));
+					assert1(move_flag(m) == MoveFlag(f));
+					assert1(move_src(m) == Square(i));
+					assert1(move_dst(m) == Square(k));
+					assert1((move_type(m) == MOVE_PROMOTION) == (f >= MOVE_FLAG_PROMOTION && f < MOVE_FLAG_PROMOTION + 4));
+				}
 			}
 		}
 	}
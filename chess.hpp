@@ -2,9 +2,9 @@
 #define CHESS_HPP
 
 #include <array>
-#include <algorithm> // piece_index, piece from index ...; std::find
-#include <iterator> // piece_index, ...... 		 ; std::distance
+#include <algorithm> // MoveList::contains; std::find
 #include <cstdint>
+#include <vector>
 #include "bitboard.hpp"
 
 namespace chess {
@@ -20,6 +20,7 @@ namespace chess {
 		A6, B6, C6, D6, E6, F6, G6, H6,
 		A7, B7, C7, D7, E7, F7, G7, H7,
 		A8, B8, C8, D8, E8, F8, G8, H8,
+		SQUARE_NONE,
 	};
 
 	constexpr std::array<char[3], SQUARE_COUNT> SQUARE_NAME {
@@ -33,15 +34,118 @@ namespace chess {
 		"a8", "b8", "c8", "d8", "e8", "f8", "g8", "h8",
 	};
 
-	inline Square square_new(int file, int rank){
+	constexpr Square square_new(int file, int rank){
 		return Square(rank*8 + file);
 	}
-	inline int square_rank(Square sq){
+	constexpr int square_rank(Square sq){
 		return sq/8;
 	}
-	inline int square_file(Square sq){
+	constexpr int square_file(Square sq){
 		return sq%8;
 	}
+	constexpr bool square_valid(int file, int rank){
+		return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+	}
+
+	// Tabelas de ataque fixas, geradas em tempo de compilação.
+	constexpr int KNIGHT_DELTAS[8][2] { {1,2}, {2,1}, {2,-1}, {1,-2}, {-1,-2}, {-2,-1}, {-2,1}, {-1,2} };
+	constexpr int KING_DELTAS[8][2] { {1,0}, {1,1}, {0,1}, {-1,1}, {-1,0}, {-1,-1}, {0,-1}, {1,-1} };
+	constexpr int PAWN_DELTAS[2][2][2] { { {-1,1}, {1,1} }, { {-1,-1}, {1,-1} } }; // brancas, negras
+
+	template<int N>
+	constexpr BitBoard leaper_attacks(Square sq, const int (&deltas)[N][2]){
+		BitBoard bb;
+		for(int i = 0; i < N; i++){
+			int f = square_file(sq) + deltas[i][0];
+			int r = square_rank(sq) + deltas[i][1];
+			if(square_valid(f, r)){
+				bb.set(square_new(f, r));
+			}
+		}
+		return bb;
+	}
+
+	inline constexpr std::array<BitBoard, SQUARE_COUNT> KNIGHT_ATTACKS = []{
+		std::array<BitBoard, SQUARE_COUNT> t {};
+		for(int sq = 0; sq < SQUARE_COUNT; sq++){
+			t[sq] = leaper_attacks(Square(sq), KNIGHT_DELTAS);
+		}
+		return t;
+	}();
+
+	inline constexpr std::array<BitBoard, SQUARE_COUNT> KING_ATTACKS = []{
+		std::array<BitBoard, SQUARE_COUNT> t {};
+		for(int sq = 0; sq < SQUARE_COUNT; sq++){
+			t[sq] = leaper_attacks(Square(sq), KING_DELTAS);
+		}
+		return t;
+	}();
+
+	// PAWN_ATTACKS[cor][quadrado]: casas que um peão dessa cor ataca
+	inline constexpr std::array<std::array<BitBoard, SQUARE_COUNT>, 2> PAWN_ATTACKS = []{
+		std::array<std::array<BitBoard, SQUARE_COUNT>, 2> t {};
+		for(int c = 0; c < 2; c++){
+			for(int sq = 0; sq < SQUARE_COUNT; sq++){
+				t[c][sq] = leaper_attacks(Square(sq), PAWN_DELTAS[c]);
+			}
+		}
+		return t;
+	}();
+
+	// BETWEEN_BB[a][b]: casas estritamente entre a e b, se alinhadas
+	// LINE_BB[a][b]: a linha inteira (de borda a borda) que passa por a e b, se alinhadas
+	inline constexpr std::array<std::array<BitBoard, SQUARE_COUNT>, SQUARE_COUNT> BETWEEN_BB = []{
+		std::array<std::array<BitBoard, SQUARE_COUNT>, SQUARE_COUNT> t {};
+		for(int a = 0; a < SQUARE_COUNT; a++){
+			for(int b = 0; b < SQUARE_COUNT; b++){
+				int df = square_file(Square(b)) - square_file(Square(a));
+				int dr = square_rank(Square(b)) - square_rank(Square(a));
+				if(a == b || (df != 0 && dr != 0 && df != dr && df != -dr)){
+					continue;
+				}
+				int sf = (df > 0) - (df < 0);
+				int sr = (dr > 0) - (dr < 0);
+				int f = square_file(Square(a)) + sf;
+				int r = square_rank(Square(a)) + sr;
+				while(square_new(f, r) != b){
+					t[a][b].set(square_new(f, r));
+					f += sf;
+					r += sr;
+				}
+			}
+		}
+		return t;
+	}();
+
+	inline constexpr std::array<std::array<BitBoard, SQUARE_COUNT>, SQUARE_COUNT> LINE_BB = []{
+		std::array<std::array<BitBoard, SQUARE_COUNT>, SQUARE_COUNT> t {};
+		for(int a = 0; a < SQUARE_COUNT; a++){
+			for(int b = 0; b < SQUARE_COUNT; b++){
+				int df = square_file(Square(b)) - square_file(Square(a));
+				int dr = square_rank(Square(b)) - square_rank(Square(a));
+				if(a == b || (df != 0 && dr != 0 && df != dr && df != -dr)){
+					continue;
+				}
+				int sf = (df > 0) - (df < 0);
+				int sr = (dr > 0) - (dr < 0);
+				t[a][b].set(a);
+				for(int dir = -1; dir <= 1; dir += 2){
+					int f = square_file(Square(a)) + dir*sf;
+					int r = square_rank(Square(a)) + dir*sr;
+					while(square_valid(f, r)){
+						t[a][b].set(square_new(f, r));
+						f += dir*sf;
+						r += dir*sr;
+					}
+				}
+			}
+		}
+		return t;
+	}();
+
+	inline bool aligned(Square a, Square b, Square c){
+		return LINE_BB[a][b].test(c);
+	}
 
 
 	// PEÇA: 0x00000000
@@ -113,58 +217,192 @@ namespace chess {
 	inline Piece piece_new(PieceType t, PieceColor c){
 		return Piece(t | (c<<4));
 	}
+
+	// valor material em centésimos de peão; o rei não se troca
+	constexpr std::array<int, PIECE_N_TYPES> PIECE_VALUE { 100, 320, 330, 500, 900, 0 };
+
+	// Par (meio-jogo, final) num só inteiro: somam-se e subtraem-se os dois de uma vez.
+	// Os 16 bits de baixo são o meio-jogo, o resto o final.
+	typedef int32_t Score;
+
+	constexpr Score make_score(int mg, int eg){
+		return Score(uint32_t(eg) << 16) + mg;
+	}
+	constexpr int mg_value(Score s){
+		return int16_t(uint16_t(uint32_t(s)));
+	}
+	// o + 0x8000 desfaz o empréstimo que um meio-jogo negativo tirou ao final
+	constexpr int eg_value(Score s){
+		return int16_t(uint16_t((uint32_t(s) + 0x8000) >> 16));
+	}
+
+	// Conversões por acesso direto: indexadas pelo valor de Piece / pelo carácter.
+	constexpr int PIECE_VALUES { 32 };
+
+	inline constexpr std::array<int, PIECE_VALUES> PIECE_INDEX = []{
+		std::array<int, PIECE_VALUES> t {};
+		for(int &i : t){
+			i = PIECE_N;
+		}
+		for(int i = 0; i < PIECE_N; i++){
+			t[PIECE_LIST[i]] = i;
+		}
+		return t;
+	}();
+
+	inline constexpr std::array<char, PIECE_VALUES> PIECE_TO_CHAR = []{
+		std::array<char, PIECE_VALUES> t {};
+		for(char &c : t){
+			c = ' ';
+		}
+		for(int i = 0; i < PIECE_N; i++){
+			t[PIECE_LIST[i]] = PIECE_CHAR[i];
+		}
+		return t;
+	}();
+
+	inline constexpr std::array<Piece, 128> PIECE_FROM_CHAR = []{
+		std::array<Piece, 128> t {};
+		for(Piece &p : t){
+			p = PIECE_NULL;
+		}
+		for(int i = 0; i < PIECE_N; i++){
+			t[int(PIECE_CHAR[i])] = PIECE_LIST[i];
+		}
+		return t;
+	}();
+
 	inline int piece_index(Piece p){
-		auto it = std::find(PIECE_LIST.begin(), PIECE_LIST.end(), p);
-		return std::distance(PIECE_LIST.begin(), it);
+		return PIECE_INDEX[p];
 	}
 	inline Piece piece_from_index(int i){
 		return PIECE_LIST[i];
 	}
 	inline char piece_char(Piece p){
-		return PIECE_CHAR[piece_index(p)];
+		return PIECE_TO_CHAR[p];
 	}
+	// PIECE_NULL se c não representar uma peça
 	inline Piece piece_from_char(char c){
-		auto it = std::find(PIECE_CHAR.begin(), PIECE_CHAR.end(), c);
-		int i = std::distance(PIECE_CHAR.begin(), it);
-		return PIECE_LIST[i];
+		return PIECE_FROM_CHAR[c & 0x7F];
 	}
 
+	// 4 bits: lado do rei e da dama das brancas, depois das pretas
 	enum CastleRight : int {
-		CASTLE_WHITE = 0x01,
-		CASTLE_BLACK = 0x10,
-		CASTLE_BOTH  = 0x11,
+		CASTLE_NONE   = 0x0,
+		CASTLE_WKING  = 0x1,
+		CASTLE_WQUEEN = 0x2,
+		CASTLE_WHITE  = 0x3,
+		CASTLE_BKING  = 0x4,
+		CASTLE_BQUEEN = 0x8,
+		CASTLE_BLACK  = 0xC,
+		CASTLE_BOTH   = 0xF,
+		CASTLE_N      = 16,
 	};
 
+	inline CastleRight operator|(CastleRight a, CastleRight b){
+		return CastleRight(int(a) | int(b));
+	}
+	inline CastleRight operator&(CastleRight a, CastleRight b){
+		return CastleRight(int(a) & int(b));
+	}
+	inline CastleRight castle_kingside(PieceColor c){
+		return c == PIECE_WHITE ? CASTLE_WKING : CASTLE_BKING;
+	}
+	inline CastleRight castle_queenside(PieceColor c){
+		return c == PIECE_WHITE ? CASTLE_WQUEEN : CASTLE_BQUEEN;
+	}
+
 	enum MoveType : int {
 		MOVE_NONE,
 		MOVE_NORMAL,
+		MOVE_PROMOTION,
+		MOVE_EN_PASSANT,
+		MOVE_CASTLE, // src/dst do rei: e1g1, e1c1, e8g8, e8c8
 	};
-	enum MoveColor : int {
-		MOVE_WHITE = PIECE_WHITE,
-		MOVE_BLACK = PIECE_BLACK,
-		MOVE_COLORLESS,
+
+	// o que está guardado na jogada; move_type() agrupa-os nos casos que o código trata à parte
+	enum MoveFlag : int {
+		MOVE_FLAG_NONE,
+		MOVE_FLAG_NORMAL,
+		MOVE_FLAG_DOUBLE_PUSH, // peão duas casas: pode criar casa de en passant
+		MOVE_FLAG_CASTLE,
+		MOVE_FLAG_EN_PASSANT,
+		MOVE_FLAG_PROMOTION = 8, // 8-11: cavalo, bispo, torre, dama
 	};
 
-	typedef uint32_t Move;
+	// JOGADA: 0x0000
+	// bits 0-5: origem, 6-11: destino, 12-15: MoveFlag
+	// A cor não se guarda: é sempre a de quem joga na posição. 0 é "nenhuma jogada".
+	typedef uint16_t Move;
 
-	inline Move move_new(MoveType t, MoveColor c, Square src, Square dst){
-		return t | (c<<8) | (src<<16) | (dst<<22);
+	constexpr Move NO_MOVE { 0 };
+
+	constexpr std::array<MoveType, 16> MOVE_FLAG_TYPE {
+		MOVE_NONE, MOVE_NORMAL, MOVE_NORMAL, MOVE_CASTLE, MOVE_EN_PASSANT, MOVE_NONE, MOVE_NONE, MOVE_NONE,
+		MOVE_PROMOTION, MOVE_PROMOTION, MOVE_PROMOTION, MOVE_PROMOTION, MOVE_NONE, MOVE_NONE, MOVE_NONE, MOVE_NONE,
+	};
+
+	inline Move move_new(MoveFlag f, Square src, Square dst){
+		return Move(src | (dst<<6) | (f<<12));
 	}
-	inline Move move_new(MoveType t, MoveColor c){
-		return t | (c<<8);
+	inline Move move_new_promotion(Square src, Square dst, PieceType promo){
+		return move_new(MoveFlag(MOVE_FLAG_PROMOTION + promo - PIECE_KNIGHT), src, dst);
 	}
-	inline MoveType move_type(Move m){
-		return MoveType(m&0xFF);
+	inline MoveFlag move_flag(Move m){
+		return MoveFlag(m>>12);
 	}
-	inline MoveColor move_color(Move m){
-		return MoveColor((m>>8)&0xFF);
+	inline MoveType move_type(Move m){
+		return MOVE_FLAG_TYPE[m>>12];
 	}
 	inline Square move_src(Move m){
-		return Square((m>>16)&63);
+		return Square(m&63);
 	}
 	inline Square move_dst(Move m){
-		return Square((m>>22)&63);
+		return Square((m>>6)&63);
 	}
+	inline PieceType move_promotion(Move m){
+		return PieceType(((m>>12)&3) + PIECE_KNIGHT);
+	}
+
+	// notação de coordenadas (UCI): "e2e4", "e7e8q"; buf termina em '\0'
+	inline void move_name(Move m, char (&buf)[6]){
+		buf[0] = SQUARE_NAME[move_src(m)][0];
+		buf[1] = SQUARE_NAME[move_src(m)][1];
+		buf[2] = SQUARE_NAME[move_dst(m)][0];
+		buf[3] = SQUARE_NAME[move_dst(m)][1];
+		buf[4] = move_type(m) == MOVE_PROMOTION ? "nbrq"[move_promotion(m) - PIECE_KNIGHT] : '\0';
+		buf[5] = '\0';
+	}
+
+	constexpr int MAX_MOVES { 256 };
+
+	// Lista de jogadas de capacidade fixa, para viver na pilha.
+	struct MoveList {
+		std::array<Move, MAX_MOVES> moves;
+		int count;
+
+		MoveList(void): count{0} {}
+
+		void push(Move m){ this->moves[this->count++] = m; }
+		void clear(void){ this->count = 0; }
+		int size(void) const { return this->count; }
+		Move operator[](int i) const { return this->moves[i]; }
+		Move *begin(void){ return this->moves.data(); }
+		Move *end(void){ return this->moves.data() + this->count; }
+		const Move *begin(void) const { return this->moves.data(); }
+		const Move *end(void) const { return this->moves.data() + this->count; }
+		bool contains(Move m) const {
+			return std::find(this->begin(), this->end(), m) != this->end();
+		}
+	};
+
+	// GEN_CAPTURES inclui capturas, en passant e todas as promoções;
+	// GEN_QUIETS o resto (incluindo roques). Juntas dão GEN_ALL.
+	enum GenType : int {
+		GEN_ALL,
+		GEN_CAPTURES,
+		GEN_QUIETS,
+	};
 
 	constexpr char* DEFAULT_POSITION {
 		"rnbqkbnr"
@@ -177,54 +415,221 @@ namespace chess {
 		"RNBQKBNR"
 	};
 
+	constexpr const char *START_FEN { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+	// chega para a FEN mais comprida possível, contadores incluídos
+	constexpr int FEN_MAX { 128 };
+
+	// Chaves de Zobrist, geradas em tempo de compilação (splitmix64).
+	struct ZobristKeys {
+		uint64_t psq[PIECE_N_COLORS][PIECE_N_TYPES][SQUARE_COUNT];
+		uint64_t castle[CASTLE_N]; // indexado pelo valor de CastleRight
+		uint64_t epFile[8];
+		uint64_t side;
+	};
+
+	constexpr uint64_t splitmix64(uint64_t &state){
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	// metade alta de a * b: leva uma chave a [0, b) sem divisão
+	inline uint64_t mul_hi64(uint64_t a, uint64_t b){
+		#if defined(__SIZEOF_INT128__)
+		__extension__ typedef unsigned __int128 uint128;
+		return uint64_t(uint128(a) * b >> 64);
+		#else
+		uint64_t aLo = uint32_t(a), aHi = a >> 32;
+		uint64_t bLo = uint32_t(b), bHi = b >> 32;
+		uint64_t mid = (aLo * bLo >> 32) + uint32_t(aHi * bLo) + aLo * bHi;
+		return aHi * bHi + (aHi * bLo >> 32) + (mid >> 32);
+		#endif
+	}
+
+	inline constexpr ZobristKeys ZOBRIST = []{
+		ZobristKeys z {};
+		uint64_t seed = 0x5EED0F0C4E55ULL;
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			for(int t = 0; t < PIECE_N_TYPES; t++){
+				for(int sq = 0; sq < SQUARE_COUNT; sq++){
+					z.psq[c][t][sq] = splitmix64(seed);
+				}
+			}
+		}
+		// uma chave por direito; a de uma combinação é o XOR das chaves dos seus bits
+		uint64_t right[4] { splitmix64(seed), splitmix64(seed), splitmix64(seed), splitmix64(seed) };
+		for(int cr = 0; cr < CASTLE_N; cr++){
+			z.castle[cr] = ((cr & CASTLE_WKING) ? right[0] : 0) ^ ((cr & CASTLE_WQUEEN) ? right[1] : 0) ^
+			               ((cr & CASTLE_BKING) ? right[2] : 0) ^ ((cr & CASTLE_BQUEEN) ? right[3] : 0);
+		}
+		for(int f = 0; f < 8; f++){
+			z.epFile[f] = splitmix64(seed);
+		}
+		z.side = splitmix64(seed);
+		return z;
+	}();
+
+	inline uint64_t zobrist_piece(Piece p, Square sq){
+		return ZOBRIST.psq[piece_color(p)][piece_type(p)][sq];
+	}
+
+	// O que do_move não consegue reconstruir ao desfazer a jogada.
+	struct StateInfo {
+		uint64_t key;
+		CastleRight castleRights;
+		Square epSquare;
+		Piece captured;
+		int rule50;
+	};
+
+	struct PackedPosition;
+
 	class Position {
 		std::array<BitBoard, PIECE_N_TYPES> byTypeBB;
 		std::array<BitBoard, PIECE_N_COLORS> byColorBB;
 		BitBoard occupiedBB;
+		// redundante com os bitboards, para saber a peça de um quadrado sem os percorrer
+		std::array<Piece, SQUARE_COUNT> board;
 
 		CastleRight castleRights;
 		PieceColor sideToMove;
+		Square epSquare;
+		uint64_t key; // Zobrist, mantida de forma incremental
+		uint64_t pawnKey; // Zobrist só dos peões, para a tabela de peões
+		Score psq;    // material + peça-quadrado, do ponto de vista das brancas
+		int phase;    // soma de PHASE_WEIGHT das peças em jogo
+		int rule50;   // meias-jogadas desde a última captura ou jogada de peão
+		int gamePly;  // meias-jogadas desde o início do jogo
 
-		PieceColor get_piece_color(Square sq);
-		PieceType get_piece_type(Square sq);
+		PieceColor get_piece_color(Square sq) const;
+		PieceType get_piece_type(Square sq) const;
+		BitBoard attackers_to(Square sq, BitBoard occupied) const;
 		void set_piece(Square sq, Piece p);
 		void empty_square(Square sq);
+		// só mexem nos bits do quadrado indicado; a peça tem de ser conhecida
+		void put_piece(Square sq, Piece p);
+		void remove_piece(Square sq, Piece p);
+		void move_piece(Square src, Square dst, Piece p);
 
-		bool is_normal_legal(Move m);
-		void apply_normal(Move m);
+		BitBoard pinned_pieces(PieceColor c) const;
 
 		void switch_side(void);
+		// numa posição vazia: põe pieces[i] na i-ésima casa de occupied (da mais baixa para
+		// a mais alta) e calcula bitboards, chaves das peças, psq e fase de uma vez
+		void place_pieces(BitBoard occupied, const Piece *pieces);
+		// junta à chave o que não são peças: roque, en passant e a vez
+		void add_state_key(void);
 
 		public:
-		Position(void) : castleRights { CASTLE_BOTH }, sideToMove { PIECE_WHITE }{}
+		Position(void) : castleRights { CASTLE_NONE }, sideToMove { PIECE_WHITE }, epSquare { SQUARE_NONE }, key { 0 },
+		                 pawnKey { 0 }, psq { 0 }, phase { 0 }, rule50 { 0 }, gamePly { 0 }{
+			board.fill(PIECE_NULL);
+		}
 		Position copy(void){
 			return *this;
 		}
 		
 		static Position from_string(char *str);
-		Piece get_piece(Square sq);
-		Piece get_piece(int file, int rank){ return get_piece(square_new(file, rank)); };
-		bool is_legal(Move m);
+		// devolve false se a FEN estiver mal formada; os contadores são opcionais (0 e 1)
+		static bool from_fen(const char *fen, Position &pos);
+		// lê uma FEN de [fen, end) e devolve onde acabou (o resto da linha, p.ex. operações
+		// EPD, fica por ler) ou nullptr se estiver mal formada; não precisa de '\0'
+		static const char *from_fen(const char *fen, const char *end, Position &pos);
+		// escreve a FEN completa em buf, terminada em '\0'; devolve o comprimento
+		int to_fen(char (&buf)[FEN_MAX]) const;
+		// formato de 32 bytes; ver pack.hpp. pack devolve false com mais de 32 peças
+		bool pack(PackedPosition &pp) const;
+		static bool unpack(const PackedPosition &pp, Position &pos);
+		// sem roque nem en passant, com pieces[i] em squares[i]; false se duas peças
+		// calharem na mesma casa, não houver um rei de cada cor ou quem não joga estiver
+		// em xeque. Para as tabelas de finais (ver tablebase.hpp)
+		static bool from_pieces(const Piece *pieces, const Square *squares, int n, PieceColor stm, Position &pos);
+		BitBoard pieces(void) const { return this->occupiedBB; }
+		BitBoard pieces(PieceColor c) const { return this->byColorBB[c]; }
+		BitBoard pieces(PieceType t) const { return this->byTypeBB[t]; }
+		BitBoard pieces(PieceColor c, PieceType t) const { return this->byColorBB[c] & this->byTypeBB[t]; }
+		Piece get_piece(Square sq) const { return this->board[sq]; }
+		Piece get_piece(int file, int rank) const { return get_piece(square_new(file, rank)); };
+		PieceColor side_to_move(void) const { return this->sideToMove; }
+		CastleRight castle_rights(void) const { return this->castleRights; }
+		Square ep_square(void) const { return this->epSquare; }
+		int halfmove_clock(void) const { return this->rule50; }
+		int fullmove_number(void) const { return 1 + this->gamePly / 2; }
+		uint64_t get_key(void) const { return this->key; }
+		// só muda quando um peão entra, sai ou mexe
+		uint64_t pawn_key(void) const { return this->pawnKey; }
+		// recalculam as chaves de raiz; só para verificação
+		uint64_t compute_key(void) const;
+		uint64_t compute_pawn_key(void) const;
+		// mantidos por put_piece/remove_piece/move_piece; ver psqt.hpp
+		Score psq_score(void) const { return this->psq; }
+		int game_phase(void) const { return this->phase; }
+		// recalcula os dois de raiz; só para verificação
+		Score compute_psq(void) const;
+		int compute_phase(void) const;
+		// chave depois de m, barata mas aproximada (ignora a torre do roque, a peça
+		// promovida e uma nova casa de en passant); serve para prefetch da tabela de transposição
+		uint64_t key_after(Move m) const;
+		Square king_square(PieceColor c) const {
+			return Square(this->pieces(c, PIECE_KING).lsb());
+		}
+		BitBoard checkers(void) const {
+			Square ksq = this->king_square(this->sideToMove);
+			return this->attackers_to(ksq, this->occupiedBB) & this->byColorBB[~this->sideToMove];
+		}
+		bool in_check(void) const { return this->checkers().any(); }
+		// troca estática: true se a sequência de capturas em move_dst(m) deixa quem
+		// joga com pelo menos `threshold`. Só avalia jogadas normais; as outras valem 0.
+		bool see_ge(Move m, int threshold = 0) const;
+		bool is_capture(Move m) const {
+			return this->board[move_dst(m)] != PIECE_NULL || move_type(m) == MOVE_EN_PASSANT;
+		}
+		// peça capturada por m (peão no caso de en passant)
+		Piece captured_piece(Move m) const {
+			return move_type(m) == MOVE_EN_PASSANT ? piece_new(PIECE_PAWN, ~this->sideToMove) : this->board[move_dst(m)];
+		}
+		bool has_non_pawn_material(PieceColor c) const {
+			return (this->byColorBB[c] & ~this->byTypeBB[PIECE_PAWN] & ~this->byTypeBB[PIECE_KING]).any();
+		}
+
+		void generate_legal(MoveList &list, GenType type = GEN_ALL) const;
+		Move find_move(Square src, Square dst) const;
+		// barato para jogadas de tipo normal; serve para validar jogadas da TT
+		bool is_legal(Move m) const;
 		bool make_move(Move m);
+		// sem verificação de legalidade; st guarda o necessário para undo_move
+		void do_move(Move m, StateInfo &st);
+		void undo_move(Move m, const StateInfo &st);
+		// passa a vez sem jogar (poda de jogada nula na pesquisa)
+		void do_null_move(StateInfo &st);
+		void undo_null_move(const StateInfo &st);
 	};
 
 	constexpr int BUFSIZE { 2048 };
+	constexpr int GAME_RESERVE_PLY { 1024 };
 
 	class Game {
 		Position currPosition;
+		std::vector<Move> moves;
+		std::vector<StateInfo> states;
 
 		public:
 		Game(void){
 			currPosition = Position::from_string(DEFAULT_POSITION);
+			moves.reserve(GAME_RESERVE_PLY);
+			states.reserve(GAME_RESERVE_PLY);
 		}
 
 		bool make_move(Move m);
+		bool undo_move(void);
 		Position get_position(void){
 			return currPosition;
 		}
 
 	};
 
+	void init(void);
 	void test(void);
 }
 
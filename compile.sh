@@ -1,7 +1,16 @@
 #!/usr/bin/bash
+# uso: ./compile.sh [main] [perft] [bench] [uci]   (sem argumentos compila todos)
+# -march=native liga POPCNT/TZCNT e, havendo BMI2, PEXT/PDEP (ver bitboard.hpp)
+ARCHFLAGS=${ARCHFLAGS:-"-march=native"}
+# -DCHESS_DEBUG liga as verificações caras (ex.: chave de Zobrist recalculada a cada jogada)
+DEBUGFLAGS=${DEBUGFLAGS:-"-O0 -g3 -DCHESS_DEBUG"}
 WFLAGS="-Wall -Wextra -Wpedantic -Wno-c++17-attribute-extensions -Wno-writable-strings"
-SDLFLAGS=$(pkg-config --libs --cflags sdl2)
-SDLIMAGEFLAGS=$(pkg-config --libs --cflags SDL2_image)
+
+# código comum a todos os executáveis
+LIBSRC="alloc.cpp chess.cpp attacks.cpp tt.cpp threadpool.cpp pawns.cpp evaluate.cpp movepick.cpp nnue.cpp search.cpp mappedfile.cpp fenfile.cpp pgn.cpp pack.cpp book.cpp tablebase.cpp"
+THREADFLAGS="-pthread"
+
+TARGETS=${@:-"main perft bench uci"}
 
 mkdir -p ./objects
 
@@ -10,11 +19,55 @@ function run_cmd(){
 	$1
 }
 
-for file in *.cpp
-do
-	CMD="clang++ $WFLAGS $SDLFLAGS $SDLIMAGEFLAGS -O0 -g3 $file -o objects/"$file".o -c"
+function compile(){
+	CMD="clang++ $WFLAGS $2 $THREADFLAGS $ARCHFLAGS $DEBUGFLAGS $1 -o objects/"$1".o -c"
 	run_cmd "$CMD"
+}
+
+function objects(){
+	for file in $@
+	do
+		echo -n "objects/$file.o "
+	done
+}
+
+for file in $LIBSRC
+do
+	compile $file
 done
 
-CMD="clang++ $SDLFLAGS $SDLIMAGEFLAGS -O0 -g3 objects/*.o -o main"
-run_cmd "$CMD"
+for target in $TARGETS
+do
+	case $target in
+		main)
+			SDLFLAGS=$(pkg-config --libs --cflags sdl2)
+			SDLIMAGEFLAGS=$(pkg-config --libs --cflags SDL2_image)
+			SRC="main.cpp graphics.cpp"
+			for file in $SRC
+			do
+				compile $file "$SDLFLAGS $SDLIMAGEFLAGS"
+			done
+			CMD="clang++ $SDLFLAGS $SDLIMAGEFLAGS $THREADFLAGS $DEBUGFLAGS $(objects $SRC $LIBSRC) -o main"
+			run_cmd "$CMD"
+			;;
+		perft)
+			compile perft.cpp
+			CMD="clang++ $THREADFLAGS $DEBUGFLAGS $(objects perft.cpp $LIBSRC) -o perft"
+			run_cmd "$CMD"
+			;;
+		bench)
+			compile bench.cpp
+			CMD="clang++ $THREADFLAGS $DEBUGFLAGS $(objects bench.cpp $LIBSRC) -o bench"
+			run_cmd "$CMD"
+			;;
+		uci)
+			compile uci.cpp
+			CMD="clang++ $THREADFLAGS $DEBUGFLAGS $(objects uci.cpp $LIBSRC) -o uci"
+			run_cmd "$CMD"
+			;;
+		*)
+			echo "alvo desconhecido: $target"
+			exit 1
+			;;
+	esac
+done
@@ -0,0 +1,17 @@
+#include "evaluate.hpp"
+#include "psqt.hpp"
+
+namespace chess {
+
+	// material e peça-quadrado já vêm atualizados da posição e a estrutura de
+	// peões quase sempre da tabela; aqui só se soma e mistura meio-jogo e final
+	int evaluate(const Position &pos, PawnTable &pawns, const Accumulator *acc){
+		if(acc != nullptr){
+			return nnue_evaluate(pos, *acc);
+		}
+		Score s = pos.psq_score() + pawns.probe(pos).score;
+		int phase = pos.game_phase() < PHASE_MAX ? pos.game_phase() : PHASE_MAX;
+		int v = (mg_value(s) * phase + eg_value(s) * (PHASE_MAX - phase)) / PHASE_MAX;
+		return pos.side_to_move() == PIECE_WHITE ? v : -v;
+	}
+}
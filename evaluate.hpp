@@ -0,0 +1,16 @@
+#ifndef EVALUATE_HPP
+#define EVALUATE_HPP
+
+#include "chess.hpp"
+#include "nnue.hpp"
+#include "pawns.hpp"
+
+namespace chess {
+
+	// valor da posição do ponto de vista de quem joga, em centésimos de peão
+	// pawns: a tabela de peões da thread que avalia
+	// acc: se não for nulo, avalia com a rede (ver nnue.hpp) em vez dos termos clássicos
+	int evaluate(const Position &pos, PawnTable &pawns, const Accumulator *acc = nullptr);
+}
+
+#endif // EVALUATE_HPP
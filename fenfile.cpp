@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstring>
+#include "fenfile.hpp"
+
+namespace chess {
+
+	// blocos por thread: alguns a mais para equilibrar linhas de tamanhos diferentes
+	constexpr int FEN_CHUNKS_PER_THREAD { 8 };
+
+	struct FenChunk {
+		const char *begin;
+		const char *end;
+		size_t first; // índice em out da primeira posição do bloco
+		size_t lines;
+		size_t valid;
+		size_t invalid;
+	};
+
+	static size_t count_lines(const char *begin, const char *end);
+	static void parse_chunk(FenChunk &chunk, Position *out);
+
+	// majorante do número de posições: linhas, contando a última mesmo sem '\n'
+	static size_t count_lines(const char *begin, const char *end){
+		size_t n = 0;
+		for(const char *c = begin; c < end; c++){
+			const char *nl = static_cast<const char *>(memchr(c, '\n', end - c));
+			n++;
+			if(!nl){
+				break;
+			}
+			c = nl;
+		}
+		return n;
+	}
+
+	static void parse_chunk(FenChunk &chunk, Position *out){
+		const char *c = chunk.begin;
+		while(c < chunk.end){
+			const char *nl = static_cast<const char *>(memchr(c, '\n', chunk.end - c));
+			const char *lineEnd = nl ? nl : chunk.end;
+			const char *e = lineEnd;
+			while(e > c && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')){
+				e--;
+			}
+			if(e > c && *c != '#'){
+				if(Position::from_fen(c, e, out[chunk.valid])){
+					chunk.valid++;
+				} else {
+					chunk.invalid++;
+				}
+			}
+			c = lineEnd + 1;
+		}
+	}
+
+	size_t FenFile::load(ThreadPool &pool, std::vector<Position> &out) const {
+		const char *data = this->file.data();
+		const char *end = this->file.end();
+		size_t size = this->file.size();
+		if(!data){
+			return 0;
+		}
+
+		// limites dos blocos, acertados para o início de uma linha
+		int n = std::max(pool.size(), 1) * FEN_CHUNKS_PER_THREAD;
+		std::vector<FenChunk> chunks;
+		chunks.reserve(n);
+		const char *begin = data;
+		for(int i = 1; i <= n && begin < end; i++){
+			const char *cut = i == n ? end : data + size / n * i;
+			if(cut < begin){
+				continue;
+			}
+			const char *nl = static_cast<const char *>(memchr(cut, '\n', end - cut));
+			cut = i == n || !nl ? end : nl + 1;
+			chunks.push_back(FenChunk{begin, cut, 0, 0, 0, 0});
+			begin = cut;
+		}
+
+		// 1.ª passagem: linhas por bloco, para saber onde cada um escreve
+		for(FenChunk &chunk : chunks){
+			FenChunk *ch = &chunk;
+			pool.submit([ch](int){ ch->lines = count_lines(ch->begin, ch->end); });
+		}
+		pool.wait();
+		size_t base = out.size(), total = 0;
+		for(FenChunk &chunk : chunks){
+			chunk.first = base + total;
+			total += chunk.lines;
+		}
+		out.resize(base + total);
+
+		// 2.ª passagem: cada bloco lê as suas FEN para out[first...]
+		Position *dst = out.data();
+		for(FenChunk &chunk : chunks){
+			FenChunk *ch = &chunk;
+			pool.submit([ch, dst](int){ parse_chunk(*ch, dst + ch->first); });
+		}
+		pool.wait();
+
+		// tira os buracos deixados por linhas vazias, comentários e FEN inválidas
+		size_t next = base, invalid = 0;
+		for(const FenChunk &chunk : chunks){
+			if(chunk.first != next){
+				std::move(out.begin() + chunk.first, out.begin() + chunk.first + chunk.valid, out.begin() + next);
+			}
+			next += chunk.valid;
+			invalid += chunk.invalid;
+		}
+		out.resize(next);
+		return invalid;
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef FENFILE_HPP
+#define FENFILE_HPP
+
+#include <cstddef>
+#include <vector>
+#include "chess.hpp"
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
+
+namespace chess {
+
+	// Ficheiro de posições em FEN, uma por linha, mapeado em memória (mmap) em vez de lido.
+	// Linhas vazias e começadas por '#' são ignoradas; o que vier depois da FEN na mesma
+	// linha (operações EPD) também.
+	class FenFile {
+		MappedFile file;
+
+		public:
+		explicit FenFile(const char *path): file{path} {}
+
+		bool is_open(void) const { return this->file.is_open(); }
+		size_t bytes(void) const { return this->file.size(); }
+
+		// Junta a out as posições do ficheiro, pela ordem em que aparecem. O ficheiro é
+		// dividido em blocos de linhas inteiras que as threads de pool leem em paralelo,
+		// cada um diretamente para o seu troço de out. Devolve o número de linhas inválidas.
+		size_t load(ThreadPool &pool, std::vector<Position> &out) const;
+	};
+}
+
+#endif // FENFILE_HPP
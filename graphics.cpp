@@ -214,11 +214,12 @@ namespace graphics {
 		return file + rank*8;
 	}
 
-	chess::Move get_move(void){
+	chess::Move ChessWindow::get_move(void){
 		if((this->sq1 == -1) || (this->sq2 == -1)){
-			return chess::move_new(chess::MOVE_NONE, chess::MOVE_COLORLESS);
+			return chess::NO_MOVE;
 		}
-		return chess::move_new(chess::MOVE_NORMAL, chess
+		chess::Position pos = this->chessGame->get_position();
+		return pos.find_move(chess::Square(this->sq1), chess::Square(this->sq2));
 	}
 
 	void ChessWindow::mouse_click(SDL_MouseButtonEvent *ev){
@@ -2,6 +2,8 @@
 #include "graphics.hpp"
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv){
+	chess::init();
+
 	#if 1
 	chess::test();
 	#endif
@@ -0,0 +1,38 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mappedfile.hpp"
+
+namespace chess {
+
+	MappedFile::MappedFile(const char *path, bool sequential): bytes{nullptr}, length{0}, opened{false} {
+		int fd = open(path, O_RDONLY);
+		if(fd < 0){
+			return;
+		}
+		struct stat st;
+		if(fstat(fd, &st) == 0){
+			this->length = size_t(st.st_size);
+			if(this->length == 0){
+				this->opened = true;
+			} else {
+				void *p = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(p != MAP_FAILED){
+					madvise(p, this->length, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+					this->bytes = static_cast<const char *>(p);
+					this->opened = true;
+				} else {
+					this->length = 0;
+				}
+			}
+		}
+		close(fd);
+	}
+
+	MappedFile::~MappedFile(void){
+		if(this->bytes){
+			munmap(const_cast<char *>(this->bytes), this->length);
+		}
+	}
+}
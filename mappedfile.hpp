@@ -0,0 +1,31 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+
+namespace chess {
+
+	// Ficheiro só de leitura mapeado em memória (mmap): o conteúdo lê-se diretamente
+	// das páginas do sistema, sem cópias nem buffers.
+	class MappedFile {
+		const char *bytes;
+		size_t length;
+		bool opened;
+
+		public:
+		// sequential: vai ser lido do princípio ao fim (o sistema lê à frente);
+		// senão, acessos espalhados (sem leitura à frente)
+		explicit MappedFile(const char *path, bool sequential = true);
+		~MappedFile(void);
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		// um ficheiro vazio está aberto, com data() == nullptr
+		bool is_open(void) const { return this->opened; }
+		const char *data(void) const { return this->bytes; }
+		const char *end(void) const { return this->bytes + this->length; }
+		size_t size(void) const { return this->length; }
+	};
+}
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,185 @@
+#include "evaluate.hpp"
+#include "movepick.hpp"
+
+namespace chess {
+
+	MovePicker::MovePicker(const Position &p, MoveBuffer &b, Move tt, const Move *killerMoves, Move counter, const ButterflyHistory &h):
+		pos{p}, history{h}, ttMove{NO_MOVE}, killers{killerMoves[0], killerMoves[1]}, counterMove{counter}, buf{b}, cur{0}, endBad{0} {
+		this->buf.list.clear();
+		this->stage = p.in_check() ? STAGE_EVASION_TT : STAGE_MAIN_TT;
+		if(p.is_legal(tt)){
+			this->ttMove = tt;
+		}
+	}
+
+	MovePicker::MovePicker(const Position &p, MoveBuffer &b, Move tt, const ButterflyHistory &h):
+		pos{p}, history{h}, ttMove{NO_MOVE}, killers{NO_MOVE, NO_MOVE}, counterMove{NO_MOVE}, buf{b}, cur{0}, endBad{0} {
+		this->buf.list.clear();
+		bool inCheck = p.in_check();
+		this->stage = inCheck ? STAGE_EVASION_TT : STAGE_QS_TT;
+		// fora de xeque a quiescência só vê capturas e promoções
+		if(p.is_legal(tt) && (inCheck || p.is_capture(tt) || move_type(tt) == MOVE_PROMOTION)){
+			this->ttMove = tt;
+		}
+	}
+
+	bool MovePicker::valid_quiet(Move m) const {
+		return m != this->ttMove && !this->pos.is_capture(m) && move_type(m) != MOVE_PROMOTION && this->pos.is_legal(m);
+	}
+
+	// capturas que a troca estática diz perderem material ficam para o fim,
+	// tal como as sub-promoções
+	bool MovePicker::good_capture(Move m) const {
+		if(move_type(m) == MOVE_PROMOTION){
+			return move_promotion(m) == PIECE_QUEEN;
+		}
+		return this->pos.see_ge(m, 0);
+	}
+
+	// MVV-LVA: primeiro a vítima mais valiosa, depois o atacante mais barato
+	void MovePicker::score_captures(int from){
+		for(int i = from; i < this->buf.list.size(); i++){
+			Move m = this->buf.list[i];
+			int s = 0;
+			if(this->pos.is_capture(m)){
+				s += 16*PIECE_VALUE[piece_type(this->pos.captured_piece(m))] - piece_type(this->pos.get_piece(move_src(m)));
+			}
+			if(move_type(m) == MOVE_PROMOTION){
+				s += PIECE_VALUE[move_promotion(m)];
+			}
+			this->buf.scores[i] = s;
+		}
+	}
+
+	void MovePicker::score_quiets(int from){
+		const auto &h = this->history[this->pos.side_to_move()];
+		for(int i = from; i < this->buf.list.size(); i++){
+			Move m = this->buf.list[i];
+			this->buf.scores[i] = h[move_src(m)][move_dst(m)];
+		}
+	}
+
+	void MovePicker::score_evasions(void){
+		this->score_quiets(0);
+		for(int i = 0; i < this->buf.list.size(); i++){
+			Move m = this->buf.list[i];
+			if(this->pos.is_capture(m)){
+				this->buf.scores[i] = (1 << 20) + 16*PIECE_VALUE[piece_type(this->pos.captured_piece(m))] -
+				                  piece_type(this->pos.get_piece(move_src(m)));
+			}
+		}
+	}
+
+	// seleção: só se ordena o que chega a ser visitado
+	Move MovePicker::select(void){
+		int best = this->cur;
+		for(int k = this->cur + 1; k < this->buf.list.size(); k++){
+			if(this->buf.scores[k] > this->buf.scores[best]){
+				best = k;
+			}
+		}
+		std::swap(this->buf.list.moves[this->cur], this->buf.list.moves[best]);
+		std::swap(this->buf.scores[this->cur], this->buf.scores[best]);
+		return this->buf.list.moves[this->cur++];
+	}
+
+	Move MovePicker::next(void){
+		Move m;
+		switch(this->stage){
+			case STAGE_MAIN_TT:
+			case STAGE_EVASION_TT:
+			case STAGE_QS_TT:
+				this->stage++;
+				if(this->ttMove != NO_MOVE){
+					return this->ttMove;
+				}
+				return this->next();
+
+			case STAGE_CAPTURE_INIT:
+			case STAGE_QS_CAPTURE_INIT:
+				this->pos.generate_legal(this->buf.list, GEN_CAPTURES);
+				this->score_captures(0);
+				this->stage++;
+				return this->next();
+
+			case STAGE_GOOD_CAPTURE:
+				while(this->cur < this->buf.list.size()){
+					m = this->select();
+					if(m == this->ttMove){
+						continue;
+					}
+					if(this->good_capture(m)){
+						return m;
+					}
+					// já consumida, pode ir para o início da lista
+					this->buf.list.moves[this->endBad++] = m;
+				}
+				this->stage++;
+				return this->next();
+
+			case STAGE_KILLER1:
+			case STAGE_KILLER2:
+				m = this->killers[this->stage - STAGE_KILLER1];
+				this->stage++;
+				if(this->valid_quiet(m)){
+					return m;
+				}
+				return this->next();
+
+			case STAGE_COUNTER:
+				m = this->counterMove;
+				this->stage++;
+				if(m != this->killers[0] && m != this->killers[1] && this->valid_quiet(m)){
+					return m;
+				}
+				return this->next();
+
+			case STAGE_QUIET_INIT:
+				this->buf.list.count = this->endBad;
+				this->pos.generate_legal(this->buf.list, GEN_QUIETS);
+				this->score_quiets(this->endBad);
+				this->cur = this->endBad;
+				this->stage++;
+				return this->next();
+
+			case STAGE_QUIET:
+				while(this->cur < this->buf.list.size()){
+					m = this->select();
+					if(m != this->ttMove && m != this->killers[0] && m != this->killers[1] && m != this->counterMove){
+						return m;
+					}
+				}
+				this->cur = 0;
+				this->stage++;
+				return this->next();
+
+			case STAGE_BAD_CAPTURE:
+				// já estão pela ordem MVV-LVA
+				if(this->cur < this->endBad){
+					return this->buf.list.moves[this->cur++];
+				}
+				this->stage = STAGE_END;
+				return NO_MOVE;
+
+			case STAGE_EVASION_INIT:
+				this->pos.generate_legal(this->buf.list);
+				this->score_evasions();
+				this->stage++;
+				return this->next();
+
+			case STAGE_EVASION:
+			case STAGE_QS_CAPTURE:
+				while(this->cur < this->buf.list.size()){
+					m = this->select();
+					if(m != this->ttMove){
+						return m;
+					}
+				}
+				this->stage = STAGE_END;
+				return NO_MOVE;
+
+			default:
+				return NO_MOVE;
+		}
+	}
+}
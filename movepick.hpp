@@ -0,0 +1,92 @@
+#ifndef MOVEPICK_HPP
+#define MOVEPICK_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include "chess.hpp"
+
+namespace chess {
+
+	// [cor][origem][destino]: quanto uma jogada calma costuma causar cortes
+	typedef std::array<std::array<std::array<int16_t, SQUARE_COUNT>, SQUARE_COUNT>, PIECE_N_COLORS> ButterflyHistory;
+	// [peça][destino] da jogada anterior -> resposta que a refutou
+	typedef std::array<std::array<Move, SQUARE_COUNT>, PIECE_N> CounterMoves;
+
+	constexpr int HISTORY_MAX { 16384 };
+
+	// o valor tende para ±HISTORY_MAX sem nunca o passar
+	inline void history_update(int16_t &h, int bonus){
+		h += bonus - h * std::abs(bonus) / HISTORY_MAX;
+	}
+
+	// Onde o MovePicker guarda as jogadas geradas e as pontuações. Vive fora dele
+	// (na pilha da pesquisa, um por ply) para a pilha de chamadas ficar pequena.
+	struct MoveBuffer {
+		MoveList list;
+		std::array<int, MAX_MOVES> scores;
+	};
+
+	// Entrega as jogadas uma a uma, por fases, gerando cada fase só quando a
+	// anterior se esgota: um corte logo na jogada da TT ou numa captura
+	// poupa a geração e a ordenação das jogadas calmas.
+	//
+	// pesquisa:    TT, capturas boas (MVV-LVA, troca estática >= 0), killers, contra-jogada,
+	//              calmas por histórico, capturas más
+	// em xeque:    TT, todas as defesas
+	// quiescência: TT, capturas e promoções
+	class MovePicker {
+		enum Stage : int {
+			STAGE_MAIN_TT,
+			STAGE_CAPTURE_INIT,
+			STAGE_GOOD_CAPTURE,
+			STAGE_KILLER1,
+			STAGE_KILLER2,
+			STAGE_COUNTER,
+			STAGE_QUIET_INIT,
+			STAGE_QUIET,
+			STAGE_BAD_CAPTURE,
+
+			STAGE_EVASION_TT,
+			STAGE_EVASION_INIT,
+			STAGE_EVASION,
+
+			STAGE_QS_TT,
+			STAGE_QS_CAPTURE_INIT,
+			STAGE_QS_CAPTURE,
+
+			STAGE_END,
+		};
+
+		const Position &pos;
+		const ButterflyHistory &history;
+		Move ttMove;
+		Move killers[2];
+		Move counterMove;
+		int stage;
+
+		// as capturas más ficam em [0, endBad); as calmas são geradas a seguir
+		MoveBuffer &buf;
+		int cur;
+		int endBad;
+
+		bool valid_quiet(Move m) const;
+		bool good_capture(Move m) const;
+		void score_captures(int from);
+		void score_quiets(int from);
+		void score_evasions(void);
+		Move select(void);
+
+		public:
+		// pesquisa principal; killers aponta para as duas killers do ply
+		// b é usado como espaço de trabalho até o MovePicker deixar de ser preciso
+		MovePicker(const Position &p, MoveBuffer &b, Move tt, const Move *killerMoves, Move counter, const ButterflyHistory &h);
+		// quiescência
+		MovePicker(const Position &p, MoveBuffer &b, Move tt, const ButterflyHistory &h);
+
+		// devolve uma jogada de tipo MOVE_NONE quando já não há mais
+		Move next(void);
+	};
+}
+
+#endif // MOVEPICK_HPP
@@ -0,0 +1,289 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "nnue.hpp"
+
+namespace chess {
+
+	struct Network {
+		int16_t *weights; // [NNUE_INPUTS][NNUE_HIDDEN], alinhado a 64
+		alignas(64) int16_t bias[NNUE_HIDDEN];
+		alignas(64) int16_t outWeights[2 * NNUE_HIDDEN];
+		int32_t outBias;
+	};
+
+	static Network NET {};
+	static bool enabled { false };
+
+	// 40960 * 256 * 2 bytes = 20 MB, reservados uma vez e nunca libertados
+	static bool alloc_weights(void){
+		if(NET.weights == nullptr){
+			size_t bytes = size_t(NNUE_INPUTS) * NNUE_HIDDEN * sizeof(int16_t);
+			NET.weights = static_cast<int16_t*>(std::aligned_alloc(64, bytes));
+		}
+		return NET.weights != nullptr;
+	}
+
+	// as pretas veem o tabuleiro espelhado na vertical, como se fossem as brancas
+	static inline int feature_index(PieceColor persp, Square ksq, Piece p, Square sq){
+		int flip = persp == PIECE_WHITE ? 0 : 56;
+		int pidx = 2 * piece_type(p) + (piece_color(p) != persp);
+		return (ksq ^ flip) * 640 + pidx * 64 + (sq ^ flip);
+	}
+
+	static inline const int16_t *feature_row(int idx){
+		return NET.weights + size_t(idx) * NNUE_HIDDEN;
+	}
+
+	// out = in + soma(add) - soma(sub), por blocos de colunas que cabem nos registos
+	static void update_columns(const int16_t *in, int16_t *out, const int16_t **add, int nAdd, const int16_t **sub, int nSub){
+		#if NNUE_SIMD_AVX2
+		constexpr int LANES = 16, REGS = 8;
+		for(int c = 0; c < NNUE_HIDDEN; c += LANES * REGS){
+			__m256i acc[REGS];
+			for(int r = 0; r < REGS; r++){
+				acc[r] = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + c + r * LANES));
+			}
+			for(int i = 0; i < nAdd; i++){
+				for(int r = 0; r < REGS; r++){
+					__m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(add[i] + c + r * LANES));
+					acc[r] = _mm256_add_epi16(acc[r], w);
+				}
+			}
+			for(int i = 0; i < nSub; i++){
+				for(int r = 0; r < REGS; r++){
+					__m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(sub[i] + c + r * LANES));
+					acc[r] = _mm256_sub_epi16(acc[r], w);
+				}
+			}
+			for(int r = 0; r < REGS; r++){
+				_mm256_store_si256(reinterpret_cast<__m256i*>(out + c + r * LANES), acc[r]);
+			}
+		}
+		#elif NNUE_SIMD_SSE
+		constexpr int LANES = 8, REGS = 8;
+		for(int c = 0; c < NNUE_HIDDEN; c += LANES * REGS){
+			__m128i acc[REGS];
+			for(int r = 0; r < REGS; r++){
+				acc[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(in + c + r * LANES));
+			}
+			for(int i = 0; i < nAdd; i++){
+				for(int r = 0; r < REGS; r++){
+					__m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(add[i] + c + r * LANES));
+					acc[r] = _mm_add_epi16(acc[r], w);
+				}
+			}
+			for(int i = 0; i < nSub; i++){
+				for(int r = 0; r < REGS; r++){
+					__m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(sub[i] + c + r * LANES));
+					acc[r] = _mm_sub_epi16(acc[r], w);
+				}
+			}
+			for(int r = 0; r < REGS; r++){
+				_mm_store_si128(reinterpret_cast<__m128i*>(out + c + r * LANES), acc[r]);
+			}
+		}
+		#else
+		for(int c = 0; c < NNUE_HIDDEN; c++){
+			int16_t v = in[c];
+			for(int i = 0; i < nAdd; i++) v += add[i][c];
+			for(int i = 0; i < nSub; i++) v -= sub[i][c];
+			out[c] = v;
+		}
+		#endif
+	}
+
+	// soma(clamp(acc, 0, 127) * w) sobre NNUE_HIDDEN colunas
+	static int32_t output_dot(const int16_t *acc, const int16_t *w){
+		#if NNUE_SIMD_AVX2
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i top = _mm256_set1_epi16(127);
+		__m256i sum = _mm256_setzero_si256();
+		for(int c = 0; c < NNUE_HIDDEN; c += 16){
+			__m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + c));
+			a = _mm256_min_epi16(_mm256_max_epi16(a, zero), top);
+			__m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(w + c));
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, b));
+		}
+		__m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+		return _mm_cvtsi128_si32(s);
+		#elif NNUE_SIMD_SSE
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i top = _mm_set1_epi16(127);
+		__m128i sum = _mm_setzero_si128();
+		for(int c = 0; c < NNUE_HIDDEN; c += 8){
+			__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + c));
+			a = _mm_min_epi16(_mm_max_epi16(a, zero), top);
+			__m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(w + c));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(a, b));
+		}
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+		return _mm_cvtsi128_si32(sum);
+		#else
+		int32_t sum = 0;
+		for(int c = 0; c < NNUE_HIDDEN; c++){
+			int v = acc[c] < 0 ? 0 : acc[c] > 127 ? 127 : acc[c];
+			sum += v * w[c];
+		}
+		return sum;
+		#endif
+	}
+
+	static void refresh_perspective(const Position &pos, PieceColor persp, int16_t *out){
+		Square ksq = pos.king_square(persp);
+		BitBoard occ = pos.pieces() & ~pos.pieces(PIECE_KING);
+		const int16_t *rows[32];
+		int n = 0;
+		for(int sq : occ){
+			rows[n++] = feature_row(feature_index(persp, ksq, pos.get_piece(Square(sq)), Square(sq)));
+		}
+		update_columns(NET.bias, out, rows, n, nullptr, 0);
+	}
+
+	bool nnue_load(const char *path){
+		FILE *f = std::fopen(path, "rb");
+		if(f == nullptr){
+			return false;
+		}
+
+		uint32_t header[3];
+		bool ok = std::fread(header, sizeof(header), 1, f) == 1 &&
+		          header[0] == NNUE_MAGIC && header[1] == uint32_t(NNUE_INPUTS) && header[2] == uint32_t(NNUE_HIDDEN);
+
+		// lê para um sítio à parte, para não deixar a rede a meio se o ficheiro for curto
+		Network tmp {};
+		size_t nWeights = size_t(NNUE_INPUTS) * NNUE_HIDDEN;
+		ok = ok && (tmp.weights = static_cast<int16_t*>(std::aligned_alloc(64, nWeights * sizeof(int16_t)))) != nullptr;
+		ok = ok && std::fread(tmp.bias, sizeof(tmp.bias), 1, f) == 1;
+		ok = ok && std::fread(tmp.weights, sizeof(int16_t), nWeights, f) == nWeights;
+		ok = ok && std::fread(tmp.outWeights, sizeof(tmp.outWeights), 1, f) == 1;
+		ok = ok && std::fread(&tmp.outBias, sizeof(tmp.outBias), 1, f) == 1;
+		std::fclose(f);
+
+		if(!ok){
+			std::free(tmp.weights);
+			return false;
+		}
+		std::free(NET.weights);
+		NET = tmp;
+		return true;
+	}
+
+	void nnue_init_random(uint64_t seed){
+		if(!alloc_weights()){
+			return;
+		}
+		uint64_t s = seed ? seed : 0x9E3779B97F4A7C15ull;
+		// xorshift64; valores pequenos para os acumuladores não saturarem
+		auto next = [&s](int range){
+			s ^= s << 13;
+			s ^= s >> 7;
+			s ^= s << 17;
+			return int16_t(int(s % uint64_t(2 * range + 1)) - range);
+		};
+		for(size_t i = 0; i < size_t(NNUE_INPUTS) * NNUE_HIDDEN; i++){
+			NET.weights[i] = next(8);
+		}
+		for(int i = 0; i < NNUE_HIDDEN; i++){
+			NET.bias[i] = next(32) + 32;
+		}
+		for(int i = 0; i < 2 * NNUE_HIDDEN; i++){
+			NET.outWeights[i] = next(64);
+		}
+		NET.outBias = 0;
+	}
+
+	bool nnue_loaded(void){
+		return NET.weights != nullptr;
+	}
+
+	void nnue_set_enabled(bool on){
+		enabled = on && nnue_loaded();
+	}
+
+	bool nnue_enabled(void){
+		return enabled;
+	}
+
+	void nnue_dirty_pieces(const Position &pos, Move m, DirtyPieces &dp){
+		Square src = move_src(m);
+		Square dst = move_dst(m);
+		MoveType t = move_type(m);
+		PieceColor us = pos.side_to_move();
+		Piece p = pos.get_piece(src);
+
+		dp.count = 1;
+		dp.piece[0] = p;
+		dp.from[0] = src;
+		dp.to[0] = t == MOVE_PROMOTION ? SQUARE_NONE : dst;
+
+		if(t == MOVE_CASTLE){
+			dp.piece[1] = piece_new(PIECE_ROOK, us);
+			dp.from[1] = square_new(dst > src ? 7 : 0, square_rank(src));
+			dp.to[1] = Square((src + dst) / 2);
+			dp.count = 2;
+			return;
+		}
+
+		Piece captured = pos.captured_piece(m);
+		if(captured != PIECE_NULL){
+			dp.piece[dp.count] = captured;
+			dp.from[dp.count] = t == MOVE_EN_PASSANT ? Square(dst ^ 8) : dst;
+			dp.to[dp.count] = SQUARE_NONE;
+			dp.count++;
+		}
+		if(t == MOVE_PROMOTION){
+			dp.piece[dp.count] = piece_new(move_promotion(m), us);
+			dp.from[dp.count] = SQUARE_NONE;
+			dp.to[dp.count] = dst;
+			dp.count++;
+		}
+	}
+
+	void nnue_refresh(const Position &pos, Accumulator &acc){
+		refresh_perspective(pos, PIECE_WHITE, acc.values[PIECE_WHITE]);
+		refresh_perspective(pos, PIECE_BLACK, acc.values[PIECE_BLACK]);
+	}
+
+	void nnue_update(const Position &pos, const DirtyPieces &dp, const Accumulator &prev, Accumulator &next){
+		for(PieceColor persp : { PIECE_WHITE, PIECE_BLACK }){
+			Square ksq = pos.king_square(persp);
+			const int16_t *add[3];
+			const int16_t *sub[3];
+			int nAdd = 0, nSub = 0;
+			bool kingMoved = false;
+
+			for(int i = 0; i < dp.count; i++){
+				Piece p = dp.piece[i];
+				if(piece_type(p) == PIECE_KING){
+					// o rei não é entrada, mas as entradas todas dependem do rei da perspetiva
+					kingMoved |= piece_color(p) == persp;
+					continue;
+				}
+				if(dp.from[i] != SQUARE_NONE){
+					sub[nSub++] = feature_row(feature_index(persp, ksq, p, dp.from[i]));
+				}
+				if(dp.to[i] != SQUARE_NONE){
+					add[nAdd++] = feature_row(feature_index(persp, ksq, p, dp.to[i]));
+				}
+			}
+
+			if(kingMoved){
+				refresh_perspective(pos, persp, next.values[persp]);
+			} else {
+				update_columns(prev.values[persp], next.values[persp], add, nAdd, sub, nSub);
+			}
+		}
+	}
+
+	int nnue_evaluate(const Position &pos, const Accumulator &acc){
+		PieceColor us = pos.side_to_move();
+		int32_t sum = NET.outBias;
+		sum += output_dot(acc.values[us], NET.outWeights);
+		sum += output_dot(acc.values[~us], NET.outWeights + NNUE_HIDDEN);
+		return sum / NNUE_OUTPUT_SCALE;
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef NNUE_HPP
+#define NNUE_HPP
+
+#include <cstdint>
+#include "chess.hpp"
+
+// Kernels vetoriais conforme o que o compilador pode gerar (-march=native).
+// -DNO_SIMD força a versão escalar, para comparar.
+#if defined(__AVX2__) && !defined(NO_SIMD)
+#define NNUE_SIMD_AVX2 1
+#define NNUE_SIMD_SSE 0
+#include <immintrin.h>
+#elif defined(__SSE4_1__) && !defined(NO_SIMD)
+#define NNUE_SIMD_AVX2 0
+#define NNUE_SIMD_SSE 1
+#include <smmintrin.h>
+#else
+#define NNUE_SIMD_AVX2 0
+#define NNUE_SIMD_SSE 0
+#endif
+
+namespace chess {
+
+	// Avaliação por rede "eficientemente atualizável" (estilo NNUE, entradas HalfKP).
+	//
+	// Entradas, para cada perspetiva (brancas e pretas): uma por (casa do próprio rei,
+	// peça que não é rei, casa da peça), com o tabuleiro espelhado para as pretas.
+	// São 64 * 10 * 64 = 40960 entradas binárias, das quais só ~30 estão ligadas.
+	//
+	// Primeira camada: NNUE_HIDDEN acumuladores int16 por perspetiva, a soma das colunas
+	// das entradas ligadas mais o viés. Uma jogada liga e desliga poucas entradas, por isso
+	// o acumulador do nó filho obtém-se do do pai com meia dúzia de somas/subtrações;
+	// só quando o rei de uma perspetiva se mexe é que essa perspetiva se recalcula toda.
+	//
+	// Saída: [quem joga, adversário] passam por ReLU limitada a [0, 127] e um produto
+	// interno com pesos int16; o resultado dividido por NNUE_OUTPUT_SCALE dá centésimos de peão.
+	//
+	// Ficheiro de pesos (little-endian):
+	//      uint32 NNUE_MAGIC, uint32 NNUE_INPUTS, uint32 NNUE_HIDDEN
+	//      int16  viés[NNUE_HIDDEN]
+	//      int16  pesos[NNUE_INPUTS][NNUE_HIDDEN]
+	//      int16  pesos de saída[2 * NNUE_HIDDEN]
+	//      int32  viés de saída
+
+	constexpr uint32_t NNUE_MAGIC { 0x314E4E58 }; // "XNN1"
+	constexpr int NNUE_INPUTS { 64 * 10 * 64 };
+	constexpr int NNUE_HIDDEN { 256 };
+	constexpr int NNUE_OUTPUT_SCALE { 256 };
+
+	struct alignas(64) Accumulator {
+		int16_t values[PIECE_N_COLORS][NNUE_HIDDEN];
+	};
+
+	// Peças que uma jogada tirou (to == SQUARE_NONE) ou pôs (from == SQUARE_NONE)
+	// ou mudou de casa. No máximo três: peça movida, captura e torre do roque
+	// ou peão/peça de promoção.
+	struct DirtyPieces {
+		int count;
+		Piece piece[3];
+		Square from[3];
+		Square to[3];
+	};
+
+	// devolve false (e deixa a rede como estava) se o ficheiro não existir ou não servir
+	bool nnue_load(const char *path);
+	// pesos pseudo-aleatórios determinísticos: só para medir velocidade
+	void nnue_init_random(uint64_t seed);
+	bool nnue_loaded(void);
+
+	// interruptor global usado por evaluate(); só liga se houver pesos
+	void nnue_set_enabled(bool on);
+	bool nnue_enabled(void);
+
+	// o que m muda no tabuleiro; chamar antes de do_move
+	void nnue_dirty_pieces(const Position &pos, Move m, DirtyPieces &dp);
+	// acumulador de raiz, somando todas as entradas
+	void nnue_refresh(const Position &pos, Accumulator &acc);
+	// acumulador depois da jogada: pos já é a posição depois de do_move
+	void nnue_update(const Position &pos, const DirtyPieces &dp, const Accumulator &prev, Accumulator &next);
+	// do ponto de vista de quem joga
+	int nnue_evaluate(const Position &pos, const Accumulator &acc);
+}
+
+#endif // NNUE_HPP
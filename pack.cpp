@@ -0,0 +1,306 @@
+#include <array>
+#include <cstring>
+#include "pack.hpp"
+
+// CRC-32C por instrução com SSE4.2; tabela nos outros casos
+#if defined(__SSE4_2__) && !defined(NO_SIMD)
+#define PACK_CRC32_HW 1
+#include <nmmintrin.h>
+#else
+#define PACK_CRC32_HW 0
+#endif
+
+namespace chess {
+
+	constexpr uint64_t NIBBLE_LOW_BITS { 0x1111111111111111ULL };
+	constexpr size_t PACK_GAME_HEADER { sizeof(PackedPosition) + 4 };
+
+	#if !PACK_CRC32_HW
+	constexpr std::array<uint32_t, 256> CRC32C_TABLE = []{
+		std::array<uint32_t, 256> t {};
+		for(uint32_t i = 0; i < 256; i++){
+			uint32_t c = i;
+			for(int k = 0; k < 8; k++){
+				c = c & 1 ? (c >> 1) ^ 0x82F63B78 : c >> 1;
+			}
+			t[i] = c;
+		}
+		return t;
+	}();
+	#endif
+
+	static void put_bits(uint64_t (&out)[2], int &bit, uint64_t v, int n);
+	static uint64_t get_bits(const uint64_t (&in)[2], int bit, int n);
+
+	// n <= 64 bits a partir de bit; o total nunca passa de 128
+	static void put_bits(uint64_t (&out)[2], int &bit, uint64_t v, int n){
+		if(n == 0){
+			return;
+		}
+		int w = bit >> 6, o = bit & 63;
+		out[w] |= v << o;
+		if(o && o + n > 64){
+			out[w + 1] |= v >> (64 - o);
+		}
+		bit += n;
+	}
+
+	static uint64_t get_bits(const uint64_t (&in)[2], int bit, int n){
+		int w = bit >> 6, o = bit & 63;
+		uint64_t v = in[w] >> o;
+		if(o && o + n > 64){
+			v |= in[w + 1] << (64 - o);
+		}
+		return n < 64 ? v & ((uint64_t(1) << n) - 1) : v;
+	}
+
+	uint32_t crc32c(const uint8_t *data, size_t n){
+		uint32_t crc = ~uint32_t(0);
+		#if PACK_CRC32_HW
+		uint64_t c = crc;
+		for(; n >= 8; data += 8, n -= 8){
+			uint64_t v;
+			memcpy(&v, data, 8);
+			c = _mm_crc32_u64(c, v);
+		}
+		crc = uint32_t(c);
+		for(; n; data++, n--){
+			crc = _mm_crc32_u8(crc, *data);
+		}
+		#else
+		for(; n; data++, n--){
+			crc = CRC32C_TABLE[(crc ^ *data) & 0xFF] ^ (crc >> 8);
+		}
+		#endif
+		return ~crc;
+	}
+
+	bool Position::pack(PackedPosition &pp) const {
+		uint64_t occ = this->occupiedBB.value();
+		if(this->occupiedBB.popcount() > 32){
+			return false;
+		}
+		// de 16 em 16 casas: os 4 bits de todas, e o PEXT deixa só os das ocupadas, seguidos
+		uint64_t out[2] = { 0, 0 };
+		int bit = 0;
+		for(int g = 0; g < 4; g++){
+			uint64_t nibbles = 0;
+			for(int i = 0; i < 16; i++){
+				nibbles |= uint64_t(piece_index(this->board[16 * g + i]) & 0xF) << (4 * i);
+			}
+			uint64_t occ16 = (occ >> (16 * g)) & 0xFFFF;
+			BitBoard mask { BitBoard::pdep(occ16, BitBoard(NIBBLE_LOW_BITS)).value() * 0xF };
+			put_bits(out, bit, BitBoard(nibbles).pext(mask), 4 * __builtin_popcountll(occ16));
+		}
+
+		pp.occupied = occ;
+		pp.pieces[0] = out[0];
+		pp.pieces[1] = out[1];
+		pp.state = uint8_t(this->castleRights | (this->sideToMove == PIECE_BLACK) << 4);
+		pp.epSquare = uint8_t(this->epSquare);
+		pp.rule50 = uint8_t(this->rule50 < 255 ? this->rule50 : 255);
+		pp.reserved = 0;
+		pp.gamePly = uint32_t(this->gamePly);
+		return true;
+	}
+
+	bool Position::unpack(const PackedPosition &pp, Position &pos){
+		pos = Position();
+		BitBoard occupied { pp.occupied };
+		int n = occupied.popcount();
+		if(n > 32 || pp.state > 0x1F || (pp.epSquare != SQUARE_NONE && pp.epSquare >= SQUARE_COUNT)){
+			return false;
+		}
+		Piece pieces[32];
+		unsigned bad = 0;
+		for(int i = 0; i < n; i++){
+			unsigned code = unsigned(get_bits(pp.pieces, 4 * i, 4));
+			bad |= code >= PIECE_N;
+			pieces[i] = PIECE_LIST[code < PIECE_N ? code : 0];
+		}
+		if(bad){
+			return false;
+		}
+		pos.place_pieces(occupied, pieces);
+		if(pos.pieces(PIECE_WHITE, PIECE_KING).popcount() != 1 ||
+		   pos.pieces(PIECE_BLACK, PIECE_KING).popcount() != 1){
+			return false;
+		}
+		pos.castleRights = CastleRight(pp.state & CASTLE_BOTH);
+		pos.sideToMove = pp.state >> 4 ? PIECE_BLACK : PIECE_WHITE;
+		pos.epSquare = Square(pp.epSquare);
+		pos.rule50 = pp.rule50;
+		pos.gamePly = int(pp.gamePly & 0x7FFFFFFF);
+		pos.add_state_key();
+		return true;
+	}
+
+	PackWriter::PackWriter(const char *path, PackKind kind): file{nullptr}, type{kind}, records{0}, ok{true} {
+		this->block.reserve(PACK_BLOCK_BYTES);
+		this->file = fopen(path, "wb");
+		if(!this->file){
+			return;
+		}
+		uint32_t header[2] = { PACK_MAGIC, kind };
+		this->ok = fwrite(header, sizeof(header), 1, this->file) == 1;
+	}
+
+	PackWriter::~PackWriter(void){
+		this->close();
+	}
+
+	bool PackWriter::flush(void){
+		if(this->records == 0){
+			return this->ok;
+		}
+		uint32_t header[2] = { uint32_t(this->block.size()), this->records };
+		uint32_t crc = crc32c(this->block.data(), this->block.size());
+		this->ok = this->ok && fwrite(header, sizeof(header), 1, this->file) == 1 &&
+		           fwrite(this->block.data(), this->block.size(), 1, this->file) == 1 &&
+		           fwrite(&crc, sizeof(crc), 1, this->file) == 1;
+		this->block.clear();
+		this->records = 0;
+		return this->ok;
+	}
+
+	// espaço para mais um registo de n bytes, fechando o bloco se não couber
+	uint8_t *PackWriter::reserve(size_t n){
+		if(this->block.size() + n > PACK_BLOCK_BYTES){
+			this->flush();
+		}
+		size_t at = this->block.size();
+		this->block.resize(at + n);
+		this->records++;
+		return this->block.data() + at;
+	}
+
+	bool PackWriter::write(const Position &pos){
+		PackedPosition pp;
+		if(!this->file || this->type != PACK_POSITIONS || !pos.pack(pp)){
+			return false;
+		}
+		memcpy(this->reserve(sizeof(pp)), &pp, sizeof(pp));
+		return this->ok;
+	}
+
+	bool PackWriter::write_game(const Position &start, const Move *moves, int count, PgnResult result){
+		PackedPosition pp;
+		if(!this->file || this->type != PACK_GAMES || count > PACK_MAX_GAME_PLY || !start.pack(pp)){
+			return false;
+		}
+		uint8_t *r = this->reserve(PACK_GAME_HEADER + 2 * size_t(count));
+		uint16_t n = uint16_t(count);
+		memcpy(r, &pp, sizeof(pp));
+		memcpy(r + sizeof(pp), &n, 2);
+		r[sizeof(pp) + 2] = uint8_t(result);
+		r[sizeof(pp) + 3] = 0;
+		memcpy(r + PACK_GAME_HEADER, moves, 2 * size_t(count));
+		return this->ok;
+	}
+
+	bool PackWriter::close(void){
+		if(!this->file){
+			return false;
+		}
+		this->flush();
+		this->ok = fclose(this->file) == 0 && this->ok;
+		this->file = nullptr;
+		return this->ok;
+	}
+
+	PackReader::PackReader(const char *path): file{nullptr}, type{PACK_POSITIONS}, offset{0}, remaining{0}, bad{false} {
+		this->block.reserve(PACK_BLOCK_BYTES);
+		FILE *f = fopen(path, "rb");
+		if(!f){
+			return;
+		}
+		uint32_t header[2];
+		if(fread(header, sizeof(header), 1, f) != 1 || header[0] != PACK_MAGIC ||
+		   (header[1] != PACK_POSITIONS && header[1] != PACK_GAMES)){
+			fclose(f);
+			return;
+		}
+		this->file = f;
+		this->type = PackKind(header[1]);
+	}
+
+	PackReader::~PackReader(void){
+		if(this->file){
+			fclose(this->file);
+		}
+	}
+
+	// false no fim do ficheiro (bad fica false) ou num bloco estragado (bad fica true)
+	bool PackReader::next_block(void){
+		uint32_t header[2];
+		size_t got = fread(header, 1, sizeof(header), this->file);
+		if(got == 0 && feof(this->file)){
+			return false;
+		}
+		uint32_t crc;
+		if(got != sizeof(header) || header[1] == 0){
+			this->bad = true;
+			return false;
+		}
+		this->block.resize(header[0]);
+		if(fread(this->block.data(), 1, header[0], this->file) != header[0] ||
+		   fread(&crc, sizeof(crc), 1, this->file) != 1 || crc != crc32c(this->block.data(), header[0])){
+			this->bad = true;
+			return false;
+		}
+		this->offset = 0;
+		this->remaining = header[1];
+		return true;
+	}
+
+	bool PackReader::read(Position &pos){
+		if(!this->file || this->bad || this->type != PACK_POSITIONS){
+			return false;
+		}
+		if(this->remaining == 0 && !this->next_block()){
+			return false;
+		}
+		PackedPosition pp;
+		if(this->offset + sizeof(pp) > this->block.size()){
+			this->bad = true;
+			return false;
+		}
+		memcpy(&pp, this->block.data() + this->offset, sizeof(pp));
+		this->offset += sizeof(pp);
+		this->remaining--;
+		if(!Position::unpack(pp, pos)){
+			this->bad = true;
+			return false;
+		}
+		return true;
+	}
+
+	bool PackReader::read_game(Position &start, std::vector<Move> &moves, PgnResult &result){
+		if(!this->file || this->bad || this->type != PACK_GAMES){
+			return false;
+		}
+		if(this->remaining == 0 && !this->next_block()){
+			return false;
+		}
+		const uint8_t *r = this->block.data() + this->offset;
+		size_t left = this->block.size() - this->offset;
+		PackedPosition pp;
+		uint16_t n;
+		if(left < PACK_GAME_HEADER){
+			this->bad = true;
+			return false;
+		}
+		memcpy(&pp, r, sizeof(pp));
+		memcpy(&n, r + sizeof(pp), 2);
+		if(left < PACK_GAME_HEADER + 2 * size_t(n) || r[sizeof(pp) + 2] > PGN_DRAW || !Position::unpack(pp, start)){
+			this->bad = true;
+			return false;
+		}
+		result = PgnResult(r[sizeof(pp) + 2]);
+		moves.resize(n);
+		memcpy(moves.data(), r + PACK_GAME_HEADER, 2 * size_t(n));
+		this->offset += PACK_GAME_HEADER + 2 * size_t(n);
+		this->remaining--;
+		return true;
+	}
+}
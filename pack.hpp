@@ -0,0 +1,99 @@
+#ifndef PACK_HPP
+#define PACK_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "chess.hpp"
+#include "pgn.hpp"
+
+namespace chess {
+
+	// Posição em 32 bytes, para guardar conjuntos grandes (uma Position ocupa mais de 300).
+	// As peças vão pela ordem das casas ocupadas, 4 bits cada (índice em PIECE_LIST):
+	// com 32 peças no máximo chegam 16 bytes. O encaixe dos 4 bits é um PEXT por cada
+	// 16 casas (ver BitBoard::pext); a leitura não precisa de nada disso.
+	struct PackedPosition {
+		uint64_t occupied;
+		uint64_t pieces[2];
+		uint8_t state;    // bits 0-3: CastleRight, bit 4: vez das pretas
+		uint8_t epSquare; // SQUARE_NONE se não houver
+		uint8_t rule50;   // limitado a 255
+		uint8_t reserved;
+		uint32_t gamePly;
+	};
+	static_assert(sizeof(PackedPosition) == 32, "PackedPosition tem de ter 32 bytes");
+
+	// Ficheiro (little-endian):
+	//      uint32 PACK_MAGIC, uint32 PackKind
+	//      blocos até ao fim: uint32 bytes, uint32 registos, registos, uint32 CRC-32C dos registos
+	// Registo de PACK_POSITIONS: PackedPosition.
+	// Registo de PACK_GAMES: PackedPosition inicial, uint16 jogadas, uint8 PgnResult,
+	// uint8 0, e as jogadas (Move de 16 bits) a partir da posição inicial.
+	// Um jogo ocupa 36 bytes mais 2 por jogada, contra 32 por posição.
+	constexpr uint32_t PACK_MAGIC { 0x314B5058 }; // "XPK1"
+	constexpr size_t PACK_BLOCK_BYTES { 1 << 16 };
+	constexpr int PACK_MAX_GAME_PLY { 0xFFFF };
+
+	enum PackKind : uint32_t {
+		PACK_POSITIONS = 1,
+		PACK_GAMES = 2,
+	};
+
+	uint32_t crc32c(const uint8_t *data, size_t n);
+
+	// Escreve em blocos de PACK_BLOCK_BYTES; um jogo maior que isso vai num bloco só seu.
+	class PackWriter {
+		FILE *file;
+		PackKind type;
+		std::vector<uint8_t> block;
+		uint32_t records;
+		bool ok;
+
+		bool flush(void);
+		uint8_t *reserve(size_t n);
+
+		public:
+		PackWriter(const char *path, PackKind kind);
+		~PackWriter(void);
+		PackWriter(const PackWriter &) = delete;
+		PackWriter &operator=(const PackWriter &) = delete;
+
+		bool is_open(void) const { return this->file != nullptr; }
+		// false se o ficheiro for do outro tipo, a posição não couber ou a escrita falhar
+		bool write(const Position &pos);
+		bool write_game(const Position &start, const Move *moves, int count, PgnResult result);
+		// escreve o último bloco; false se alguma escrita tiver falhado
+		bool close(void);
+	};
+
+	// Lê um bloco de cada vez (leitura sequencial, memória constante) e confirma o
+	// CRC antes de entregar os registos.
+	class PackReader {
+		FILE *file;
+		PackKind type;
+		std::vector<uint8_t> block;
+		size_t offset;
+		uint32_t remaining; // registos por ler no bloco atual
+		bool bad;
+
+		bool next_block(void);
+
+		public:
+		explicit PackReader(const char *path);
+		~PackReader(void);
+		PackReader(const PackReader &) = delete;
+		PackReader &operator=(const PackReader &) = delete;
+
+		bool is_open(void) const { return this->file != nullptr; }
+		PackKind kind(void) const { return this->type; }
+		// depois de read devolver false: fim do ficheiro ou erro (CRC, ficheiro cortado, registo inválido)?
+		bool failed(void) const { return this->bad; }
+
+		bool read(Position &pos);
+		// moves é reutilizado: só cresce quando aparece um jogo mais comprido
+		bool read_game(Position &start, std::vector<Move> &moves, PgnResult &result);
+	};
+}
+
+#endif // PACK_HPP
@@ -0,0 +1,104 @@
+#include <array>
+#include "pawns.hpp"
+
+namespace chess {
+
+	constexpr Score DOUBLED { make_score(11, 56) };
+	constexpr Score ISOLATED { make_score(5, 15) };
+	constexpr Score BACKWARD { make_score(9, 24) };
+	// por fila relativa (a 2.ª fila é 1)
+	constexpr std::array<Score, 8> PASSED {
+		make_score(0, 0), make_score(10, 28), make_score(17, 33), make_score(15, 41),
+		make_score(62, 72), make_score(168, 177), make_score(276, 260), make_score(0, 0),
+	};
+
+	struct PawnMasks {
+		// casas à frente na mesma coluna
+		BitBoard forward[PIECE_N_COLORS][SQUARE_COUNT];
+		// casas à frente na mesma coluna e nas vizinhas: sem peões adversários aqui, o peão é passado
+		BitBoard passedSpan[PIECE_N_COLORS][SQUARE_COUNT];
+		// colunas vizinhas, da mesma fila para trás: os peões que o podem vir a defender
+		BitBoard supportSpan[PIECE_N_COLORS][SQUARE_COUNT];
+		BitBoard adjacentFiles[8];
+	};
+
+	constexpr PawnMasks PAWN_MASKS = []{
+		PawnMasks m {};
+		for(int f = 0; f < 8; f++){
+			m.adjacentFiles[f] = (f > 0 ? file_bb(f - 1) : EMPTY_BB) | (f < 7 ? file_bb(f + 1) : EMPTY_BB);
+		}
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			for(int sq = 0; sq < SQUARE_COUNT; sq++){
+				int file = sq % 8, rank = sq / 8;
+				for(int r = 0; r < 8; r++){
+					bool ahead = c == PIECE_WHITE ? r > rank : r < rank;
+					if(ahead){
+						m.forward[c][sq] |= file_bb(file) & rank_bb(r);
+						m.passedSpan[c][sq] |= (file_bb(file) | m.adjacentFiles[file]) & rank_bb(r);
+					} else {
+						m.supportSpan[c][sq] |= m.adjacentFiles[file] & rank_bb(r);
+					}
+				}
+			}
+		}
+		return m;
+	}();
+
+	static Score evaluate_pawns(const Position &pos, PieceColor us, PawnEntry &e);
+
+	static Score evaluate_pawns(const Position &pos, PieceColor us, PawnEntry &e){
+		BitBoard ours = pos.pieces(us, PIECE_PAWN);
+		BitBoard theirs = pos.pieces(~us, PIECE_PAWN);
+		int up = us == PIECE_WHITE ? 8 : -8;
+		Score s = 0;
+
+		for(int sq : ours){
+			int rank = us == PIECE_WHITE ? sq / 8 : 7 - sq / 8;
+			bool isolated = (PAWN_MASKS.adjacentFiles[sq % 8] & ours).none();
+			bool blockedByOwn = (PAWN_MASKS.forward[us][sq] & ours).any();
+
+			if(blockedByOwn){
+				s -= DOUBLED;
+			}
+			if(isolated){
+				s -= ISOLATED;
+			} else if((PAWN_MASKS.supportSpan[us][sq] & ours).none() &&
+			          (PAWN_ATTACKS[us][sq + up] & theirs).any()){
+				// ninguém o pode defender e não pode avançar sem ser capturado
+				s -= BACKWARD;
+			}
+			if(!blockedByOwn && (PAWN_MASKS.passedSpan[us][sq] & theirs).none()){
+				s += PASSED[rank];
+				e.passed[us].set(sq);
+			}
+		}
+		return s;
+	}
+
+	PawnTable::PawnTable(size_t n): entries(n), mask{n - 1} {
+		this->clear();
+	}
+
+	// uma entrada a zeros é a entrada certa para "sem peões" (chave 0)
+	void PawnTable::clear(void){
+		for(PawnEntry &e : this->entries){
+			e = PawnEntry();
+		}
+	}
+
+	const PawnEntry &PawnTable::probe(const Position &pos){
+		uint64_t k = pos.pawn_key();
+		PawnEntry &e = this->entries[k & this->mask];
+		this->stats.probes++;
+		if(e.key == k){
+			this->stats.hits++;
+			return e;
+		}
+
+		e.key = k;
+		e.passed[PIECE_WHITE].clear();
+		e.passed[PIECE_BLACK].clear();
+		e.score = evaluate_pawns(pos, PIECE_WHITE, e) - evaluate_pawns(pos, PIECE_BLACK, e);
+		return e;
+	}
+}
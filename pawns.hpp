@@ -0,0 +1,52 @@
+#ifndef PAWNS_HPP
+#define PAWNS_HPP
+
+#include <cstdint>
+#include <vector>
+#include "chess.hpp"
+
+namespace chess {
+
+	// Termos da estrutura de peões; dependem só dos peões, por isso guardam-se
+	// numa tabela indexada por Position::pawn_key().
+	struct PawnEntry {
+		uint64_t key;
+		Score score; // do ponto de vista das brancas
+		BitBoard passed[PIECE_N_COLORS];
+	};
+
+	struct PawnStats {
+		uint64_t probes;
+		uint64_t hits;
+
+		PawnStats(void): probes{0}, hits{0} {}
+		double hit_rate(void) const {
+			return this->probes ? double(this->hits) / double(this->probes) : 0.0;
+		}
+		PawnStats &operator+=(const PawnStats &o){
+			this->probes += o.probes;
+			this->hits += o.hits;
+			return *this;
+		}
+	};
+
+	// Uma por thread de pesquisa: sem partilha não é preciso sincronizar nada.
+	class PawnTable {
+		std::vector<PawnEntry> entries;
+		uint64_t mask;
+		PawnStats stats;
+
+		public:
+		// entries tem de ser potência de 2
+		explicit PawnTable(size_t n = 16384);
+
+		// devolve a entrada da estrutura de pos, calculando-a se não estiver lá
+		const PawnEntry &probe(const Position &pos);
+		void clear(void);
+
+		const PawnStats &get_stats(void) const { return this->stats; }
+		void reset_stats(void){ this->stats = PawnStats(); }
+	};
+}
+
+#endif // PAWNS_HPP
@@ -0,0 +1,362 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "chess.hpp"
+#include "threadpool.hpp"
+
+// Contagem de nós do gerador de jogadas (perft), sem SDL.
+//
+// uso: perft [-d profundidade] [-divide] [-hash MB] [-t threads] [-split ply] [fen]
+//      perft -suite [-hash MB] [-t threads] [-split ply]
+//      perft -scale [-d profundidade] [-t threads] [-split ply] [fen]
+//
+// Com mais de uma thread a árvore é cortada a `split` meios-lances da raiz e cada
+// subárvore é uma tarefa; as contagens são somadas pela ordem das tarefas, por isso
+// o resultado é o mesmo da versão sequencial. A cache de perft é partilhada.
+// Por omissão usa todos os núcleos (-t 1 para a versão sequencial).
+//
+// Para medir velocidade compilar com otimizações, p.ex.:
+//      DEBUGFLAGS="-O3 -DNDEBUG" ./compile.sh perft
+
+using chess::Move;
+using chess::MoveList;
+using chess::Position;
+using chess::StateInfo;
+using chess::ThreadPool;
+
+constexpr int MAX_SPLIT { 8 };
+
+// Tabela (chave de Zobrist, profundidade) -> nós da subárvore.
+// Mesmo esquema "lockless" da tabela de transposição: check = chave ^ data.
+class PerftHash {
+	struct Entry {
+		uint64_t check;
+		uint64_t data; // nós << 8 | profundidade
+	};
+	std::vector<Entry> entries;
+
+	public:
+	explicit PerftHash(size_t mb): entries(mb * 1024 * 1024 / sizeof(Entry)) {}
+
+	bool probe(uint64_t key, int depth, uint64_t &nodes) const {
+		const Entry &e = this->entries[chess::mul_hi64(key, this->entries.size())];
+		uint64_t d = __atomic_load_n(&e.data, __ATOMIC_RELAXED);
+		uint64_t c = __atomic_load_n(&e.check, __ATOMIC_RELAXED);
+		if((c ^ d) != key || int(d & 0xFF) != depth){
+			return false;
+		}
+		nodes = d >> 8;
+		return true;
+	}
+	void store(uint64_t key, int depth, uint64_t nodes){
+		Entry &e = this->entries[chess::mul_hi64(key, this->entries.size())];
+		uint64_t d = (nodes << 8) | uint64_t(depth);
+		__atomic_store_n(&e.data, d, __ATOMIC_RELAXED);
+		__atomic_store_n(&e.check, key ^ d, __ATOMIC_RELAXED);
+	}
+};
+
+struct SuiteEntry {
+	const char *fen;
+	int depth;
+	uint64_t nodes;
+};
+
+// posições de referência habituais (chessprogramming.org/Perft_Results)
+static const SuiteEntry SUITE[] {
+	{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609 },
+	{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603 },
+	{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083 },
+	{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292 },
+	{ "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292 },
+	{ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487 },
+	{ "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594 },
+};
+
+// subárvore contada por uma tarefa: jogadas desde a raiz
+struct SplitTask {
+	std::array<Move, MAX_SPLIT> path;
+	int length;
+	int rootIndex;
+	uint64_t nodes;
+};
+
+struct Options {
+	int depth;
+	bool divide;
+	int threads;
+	int split;
+	PerftHash *hash;
+};
+
+static uint64_t perft(Position &pos, int depth, PerftHash *hash);
+static void collect_tasks(Position &pos, int ply, int split, SplitTask &cur, std::vector<SplitTask> &tasks);
+static uint64_t run(const Position &root, const Options &opt, ThreadPool *pool);
+static double seconds_since(std::chrono::steady_clock::time_point t);
+static int run_suite(const Options &opt, ThreadPool *pool);
+static void run_scale(const Position &root, Options opt);
+static void usage(const char *prog);
+
+// nas folhas basta contar as jogadas geradas (bulk counting)
+static uint64_t perft(Position &pos, int depth, PerftHash *hash){
+	MoveList list;
+	pos.generate_legal(list);
+	if(depth <= 1){
+		return list.size();
+	}
+
+	uint64_t nodes = 0;
+	if(hash && hash->probe(pos.get_key(), depth, nodes)){
+		return nodes;
+	}
+
+	StateInfo st;
+	for(Move m : list){
+		pos.do_move(m, st);
+		nodes += perft(pos, depth - 1, hash);
+		pos.undo_move(m, st);
+	}
+
+	if(hash){
+		hash->store(pos.get_key(), depth, nodes);
+	}
+	return nodes;
+}
+
+static void collect_tasks(Position &pos, int ply, int split, SplitTask &cur, std::vector<SplitTask> &tasks){
+	if(ply == split){
+		tasks.push_back(cur);
+		return;
+	}
+
+	MoveList list;
+	pos.generate_legal(list);
+	StateInfo st;
+	for(int i = 0; i < list.size(); i++){
+		if(ply == 0){
+			cur.rootIndex = i;
+		}
+		cur.path[ply] = list[i];
+		cur.length = ply + 1;
+		pos.do_move(list[i], st);
+		collect_tasks(pos, ply + 1, split, cur, tasks);
+		pos.undo_move(list[i], st);
+	}
+}
+
+static uint64_t run(const Position &root, const Options &opt, ThreadPool *pool){
+	if(opt.depth <= 0){
+		return 1;
+	}
+
+	// sem threads só o divide precisa de cortar, e basta um meio-lance
+	int split = pool ? opt.split : 0;
+	if(split > MAX_SPLIT){
+		split = MAX_SPLIT;
+	}
+	if(split >= opt.depth){
+		split = opt.depth - 1;
+	}
+	if(opt.divide && split < 1){
+		split = 1;
+	}
+
+	Position pos { root };
+	if(split <= 0 && !opt.divide){
+		return perft(pos, opt.depth, opt.hash);
+	}
+
+	std::vector<SplitTask> tasks;
+	SplitTask cur {};
+	collect_tasks(pos, 0, split, cur, tasks);
+
+	int remaining = opt.depth - split;
+	if(pool){
+		// uma Position por thread; cada tarefa parte da raiz e repete o caminho
+		std::vector<Position> positions(pool->size(), root);
+		for(SplitTask &t : tasks){
+			SplitTask *task = &t;
+			pool->submit([task, remaining, &positions, &root, &opt](int worker){
+				Position &p = positions[worker];
+				StateInfo states[MAX_SPLIT];
+				p = root;
+				for(int i = 0; i < task->length; i++){
+					p.do_move(task->path[i], states[i]);
+				}
+				task->nodes = remaining > 0 ? perft(p, remaining, opt.hash) : 1;
+			});
+		}
+		pool->wait();
+	} else {
+		for(SplitTask &t : tasks){
+			StateInfo states[MAX_SPLIT];
+			for(int i = 0; i < t.length; i++){
+				pos.do_move(t.path[i], states[i]);
+			}
+			t.nodes = remaining > 0 ? perft(pos, remaining, opt.hash) : 1;
+			for(int i = t.length - 1; i >= 0; i--){
+				pos.undo_move(t.path[i], states[i]);
+			}
+		}
+	}
+
+	uint64_t total = 0;
+	uint64_t rootNodes = 0;
+	for(size_t i = 0; i < tasks.size(); i++){
+		total += tasks[i].nodes;
+		rootNodes += tasks[i].nodes;
+		if(opt.divide && (i + 1 == tasks.size() || tasks[i+1].rootIndex != tasks[i].rootIndex)){
+			char name[6];
+			chess::move_name(tasks[i].path[0], name);
+			printf("%s: %llu\n", name, (unsigned long long)rootNodes);
+			rootNodes = 0;
+		}
+	}
+	if(opt.divide){
+		printf("\n");
+	}
+	return total;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+static int run_suite(const Options &opt, ThreadPool *pool){
+	int failed = 0;
+	uint64_t totalNodes = 0;
+	double totalTime = 0;
+
+	for(const SuiteEntry &e : SUITE){
+		Position pos;
+		if(!Position::from_fen(e.fen, pos)){
+			fprintf(stderr, "FEN inválida: %s\n", e.fen);
+			return 1;
+		}
+
+		Options o { opt };
+		o.depth = e.depth;
+		o.divide = false;
+		auto start = std::chrono::steady_clock::now();
+		uint64_t nodes = run(pos, o, pool);
+		double t = seconds_since(start);
+
+		bool ok = nodes == e.nodes;
+		failed += !ok;
+		totalNodes += nodes;
+		totalTime += t;
+		printf("%s d%d %12llu %8.3fs %12.0f nps  %s\n", ok ? "ok  " : "FAIL", e.depth,
+		       (unsigned long long)nodes, t, t > 0 ? nodes / t : 0.0, e.fen);
+		if(!ok){
+			printf("      esperado %llu\n", (unsigned long long)e.nodes);
+		}
+	}
+
+	printf("\ntotal %llu nós em %.3fs, %.0f nps, %d falhas\n", (unsigned long long)totalNodes,
+	       totalTime, totalTime > 0 ? totalNodes / totalTime : 0.0, failed);
+	return failed ? 1 : 0;
+}
+
+// mede com 1, 2, 4, ... threads até opt.threads e mostra a aceleração em relação a 1
+static void run_scale(const Position &root, Options opt){
+	std::vector<int> counts;
+	for(int n = 1; n < opt.threads; n *= 2){
+		counts.push_back(n);
+	}
+	counts.push_back(opt.threads);
+
+	// sem cache: com ela, as corridas seguintes aproveitariam o trabalho das anteriores
+	opt.hash = nullptr;
+	opt.divide = false;
+
+	double base = 0;
+	uint64_t expected = 0;
+	printf("threads          nós     tempo            nps  aceleração  eficiência\n");
+	for(int n : counts){
+		ThreadPool pool(n);
+		auto start = std::chrono::steady_clock::now();
+		uint64_t nodes = run(root, opt, &pool);
+		double t = seconds_since(start);
+		if(n == 1){
+			base = t;
+			expected = nodes;
+		}
+		double speedup = t > 0 ? base / t : 0.0;
+		printf("%7d %12llu %8.3fs %14.0f %10.2fx %10.0f%%%s\n", n, (unsigned long long)nodes, t,
+		       t > 0 ? nodes / t : 0.0, speedup, 100.0 * speedup / n, nodes == expected ? "" : "  DIFERENTE");
+	}
+}
+
+static void usage(const char *prog){
+	fprintf(stderr, "uso: %s [-d profundidade] [-divide] [-hash MB] [-t threads] [-split ply] [fen]\n", prog);
+	fprintf(stderr, "     %s -suite [-hash MB] [-t threads] [-split ply]\n", prog);
+	fprintf(stderr, "     %s -scale [-d profundidade] [-t threads] [-split ply] [fen]\n", prog);
+}
+
+int main(int argc, char **argv){
+	Options opt { 5, false, 0, 2, nullptr };
+	bool suite = false;
+	bool scale = false;
+	size_t hashMB = 0;
+	const char *fen = chess::START_FEN;
+
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-d") && i + 1 < argc){
+			opt.depth = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "-hash") && i + 1 < argc){
+			hashMB = strtoull(argv[++i], nullptr, 10);
+		} else if(!strcmp(argv[i], "-t") && i + 1 < argc){
+			opt.threads = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "-split") && i + 1 < argc){
+			opt.split = atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "-divide")){
+			opt.divide = true;
+		} else if(!strcmp(argv[i], "-suite")){
+			suite = true;
+		} else if(!strcmp(argv[i], "-scale")){
+			scale = true;
+		} else if(argv[i][0] != '-'){
+			fen = argv[i];
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if(opt.threads < 1){
+		opt.threads = int(std::thread::hardware_concurrency());
+		opt.threads = opt.threads < 1 ? 1 : opt.threads;
+	}
+
+	chess::init();
+
+	Position pos;
+	if(!suite && !Position::from_fen(fen, pos)){
+		fprintf(stderr, "FEN inválida: %s\n", fen);
+		return 2;
+	}
+
+	opt.hash = hashMB ? new PerftHash(hashMB) : nullptr;
+	int ret = 0;
+
+	if(scale){
+		run_scale(pos, opt);
+	} else {
+		ThreadPool *pool = opt.threads > 1 ? new ThreadPool(opt.threads) : nullptr;
+		if(suite){
+			ret = run_suite(opt, pool);
+		} else {
+			auto start = std::chrono::steady_clock::now();
+			uint64_t nodes = run(pos, opt, pool);
+			double t = seconds_since(start);
+			printf("nós: %llu\ntempo: %.3fs\nnps: %.0f\n", (unsigned long long)nodes, t, t > 0 ? nodes / t : 0.0);
+		}
+		delete pool;
+	}
+
+	delete opt.hash;
+	return ret;
+}
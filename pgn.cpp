@@ -0,0 +1,409 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "attacks.hpp"
+#include "pgn.hpp"
+
+namespace chess {
+
+	// blocos por thread: alguns a mais para equilibrar jogos de tamanhos diferentes
+	constexpr int PGN_CHUNKS_PER_THREAD { 8 };
+	// jogadas reservadas por bloco; um jogo mais comprido só faz crescer o buffer uma vez
+	constexpr int PGN_RESERVE_PLY { 1024 };
+
+	struct PgnChunk {
+		const char *begin;
+		const char *end;
+		PgnStats stats;
+	};
+
+	// estado do jogo que está a ser lido
+	struct PgnReader {
+		const char *text;  // início do jogo no ficheiro; nullptr entre jogos
+		Position start;
+		Position current;
+		StateInfo st;      // as jogadas nunca se desfazem: basta um
+		std::vector<Move> moves;
+		PgnResult result;
+		bool error;
+	};
+
+	static bool is_space(char c);
+	static bool is_file(char c);
+	static bool is_rank(char c);
+	static PieceType san_piece(char c);
+	static const char *next_game(const char *c, const char *begin, const char *end);
+	static const char *skip_variation(const char *c, const char *end);
+	static PgnResult parse_result(const char *begin, const char *end);
+	static bool is_zero_castle(const char *begin, const char *end);
+	static void begin_game(PgnReader &r, const Position &initial, const char *text);
+	static void end_game(PgnReader &r, const char *textEnd, int worker, const PgnVisitor &visit, PgnStats &stats);
+	static const char *read_tag(PgnReader &r, const char *c, const char *end);
+	static void replay_chunk(PgnChunk &chunk, int worker, const PgnVisitor &visit);
+
+	static bool is_space(char c){
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	static bool is_file(char c){
+		return c >= 'a' && c <= 'h';
+	}
+
+	static bool is_rank(char c){
+		return c >= '1' && c <= '8';
+	}
+
+	// letra de peça da SAN (sempre maiúscula); PIECE_TYPELESS se não for
+	static PieceType san_piece(char c){
+		switch(c){
+			case 'N': return PIECE_KNIGHT;
+			case 'B': return PIECE_BISHOP;
+			case 'R': return PIECE_ROOK;
+			case 'Q': return PIECE_QUEEN;
+			case 'K': return PIECE_KING;
+			default: return PIECE_TYPELESS;
+		}
+	}
+
+	Move san_to_move(const Position &pos, const char *begin, const char *end){
+		while(end > begin && (end[-1] == '+' || end[-1] == '#' || end[-1] == '!' || end[-1] == '?')){
+			end--;
+		}
+		if(end - begin < 2){
+			return NO_MOVE;
+		}
+		PieceColor us = pos.side_to_move();
+
+		if(begin[0] == 'O' || begin[0] == '0'){
+			Square ksq = pos.king_square(us);
+			int n = int(end - begin);
+			if(n != 3 && n != 5){
+				return NO_MOVE;
+			}
+			Move m = move_new(MOVE_FLAG_CASTLE, ksq, Square(ksq + (n == 5 ? -2 : 2)));
+			return pos.is_legal(m) ? m : NO_MOVE;
+		}
+
+		PieceType type = san_piece(begin[0]);
+		if(type != PIECE_TYPELESS){
+			begin++;
+		} else {
+			type = PIECE_PAWN;
+		}
+
+		// promoção: "e8=Q" ou "e8Q"
+		PieceType promo = PIECE_TYPELESS;
+		if(type == PIECE_PAWN && san_piece(end[-1]) != PIECE_TYPELESS){
+			promo = san_piece(end[-1]);
+			end -= end[-2] == '=' ? 2 : 1;
+		}
+		if(end - begin < 2 || !is_file(end[-2]) || !is_rank(end[-1])){
+			return NO_MOVE;
+		}
+		Square dst = square_new(end[-2] - 'a', end[-1] - '1');
+		end -= 2;
+
+		// o que sobra é desambiguação e 'x'
+		BitBoard from = pos.pieces(us, type);
+		bool capture = false;
+		for(const char *c = begin; c < end; c++){
+			if(is_file(*c)){
+				from &= file_bb(*c - 'a');
+				// um peão que não sai da coluna do destino captura ("exd5", "ed5")
+				capture |= type == PIECE_PAWN && *c - 'a' != square_file(dst);
+			} else if(is_rank(*c)){
+				from &= rank_bb(*c - '1');
+			} else if(*c == 'x' || *c == ':'){
+				capture = true;
+			} else if(*c != '-'){
+				return NO_MOVE;
+			}
+		}
+
+		if(type != PIECE_PAWN){
+			for(int src : piece_attacks(type, dst, pos.pieces()) & from){
+				Move m = move_new(MOVE_FLAG_NORMAL, Square(src), dst);
+				if(pos.is_legal(m)){
+					return m;
+				}
+			}
+			return NO_MOVE;
+		}
+
+		bool lastRank = square_rank(dst) == (us == PIECE_WHITE ? 7 : 0);
+		if(lastRank != (promo != PIECE_TYPELESS) || promo == PIECE_KING){
+			return NO_MOVE;
+		}
+		if(capture){
+			for(int src : PAWN_ATTACKS[~us][dst] & from){
+				Move m = promo != PIECE_TYPELESS ? move_new_promotion(Square(src), dst, promo) :
+				         move_new(dst == pos.ep_square() ? MOVE_FLAG_EN_PASSANT : MOVE_FLAG_NORMAL, Square(src), dst);
+				if(pos.is_legal(m)){
+					return m;
+				}
+			}
+			return NO_MOVE;
+		}
+
+		int up = us == PIECE_WHITE ? 8 : -8;
+		Square src = Square(dst - up);
+		Move m;
+		if(src >= 0 && src < SQUARE_COUNT && from.test(src)){
+			m = promo != PIECE_TYPELESS ? move_new_promotion(src, dst, promo) : move_new(MOVE_FLAG_NORMAL, src, dst);
+		} else if(square_rank(dst) == (us == PIECE_WHITE ? 3 : 4) && from.test(dst - 2*up)){
+			m = move_new(MOVE_FLAG_DOUBLE_PUSH, Square(dst - 2*up), dst);
+		} else {
+			return NO_MOVE;
+		}
+		return pos.is_legal(m) ? m : NO_MOVE;
+	}
+
+	// Início do primeiro jogo em [c, end): uma linha começada por '[' que não venha
+	// logo a seguir a outra etiqueta. end se não houver.
+	static const char *next_game(const char *c, const char *begin, const char *end){
+		while(c < end){
+			const char *nl = static_cast<const char *>(memchr(c, '\n', end - c));
+			if(!nl){
+				return end;
+			}
+			c = nl + 1;
+			if(c < end && *c == '['){
+				const char *prev = nl;
+				while(prev > begin && is_space(prev[-1])){
+					prev--;
+				}
+				if(prev == begin || prev[-1] != ']'){
+					return c;
+				}
+			}
+		}
+		return end;
+	}
+
+	// c aponta para '('; devolve o que vem depois do ')' correspondente. Os comentários
+	// lá dentro podem ter parênteses.
+	static const char *skip_variation(const char *c, const char *end){
+		int depth = 0;
+		for(; c < end; c++){
+			if(*c == '('){
+				depth++;
+			} else if(*c == ')' && --depth == 0){
+				return c + 1;
+			} else if(*c == '{'){
+				const char *close = static_cast<const char *>(memchr(c, '}', end - c));
+				if(!close){
+					return end;
+				}
+				c = close;
+			}
+		}
+		return end;
+	}
+
+	// PGN_RESULT_NONE também quando não é um resultado
+	static PgnResult parse_result(const char *begin, const char *end){
+		size_t n = end - begin;
+		if(n == 3 && !memcmp(begin, "1-0", 3)){
+			return PGN_WHITE_WINS;
+		}
+		if(n == 3 && !memcmp(begin, "0-1", 3)){
+			return PGN_BLACK_WINS;
+		}
+		if(n == 7 && !memcmp(begin, "1/2-1/2", 7)){
+			return PGN_DRAW;
+		}
+		return PGN_RESULT_NONE;
+	}
+
+	// roque escrito com zeros ("0-0", "0-0-0"): parece um número de jogada
+	static bool is_zero_castle(const char *begin, const char *end){
+		return end - begin >= 3 && !memcmp(begin, "0-0", 3);
+	}
+
+	static void begin_game(PgnReader &r, const Position &initial, const char *text){
+		r.text = text;
+		r.start = initial;
+		r.current = initial;
+		r.moves.clear();
+		r.result = PGN_RESULT_NONE;
+		r.error = false;
+	}
+
+	static void end_game(PgnReader &r, const char *textEnd, int worker, const PgnVisitor &visit, PgnStats &stats){
+		if(!r.text){
+			return;
+		}
+		if(r.error){
+			stats.errors++;
+		} else {
+			PgnGame game { r.text, size_t(textEnd - r.text), r.start, r.moves.data(), int(r.moves.size()), r.result };
+			visit(worker, game);
+			stats.games++;
+			stats.moves += r.moves.size();
+		}
+		r.text = nullptr;
+	}
+
+	// [Nome "valor"]; c aponta para '['. Só FEN e Result mudam alguma coisa.
+	static const char *read_tag(PgnReader &r, const char *c, const char *end){
+		const char *close = static_cast<const char *>(memchr(c, '\n', end - c));
+		const char *lineEnd = close ? close : end;
+		const char *name = c + 1;
+		const char *nameEnd = name;
+		while(nameEnd < lineEnd && !is_space(*nameEnd) && *nameEnd != '"'){
+			nameEnd++;
+		}
+		const char *value = static_cast<const char *>(memchr(nameEnd, '"', lineEnd - nameEnd));
+		if(!value){
+			return lineEnd;
+		}
+		value++;
+		const char *valueEnd = value;
+		while(valueEnd < lineEnd && *valueEnd != '"'){
+			valueEnd += *valueEnd == '\\' ? 2 : 1;
+		}
+		valueEnd = std::min(valueEnd, lineEnd);
+
+		size_t n = nameEnd - name;
+		if(n == 3 && !memcmp(name, "FEN", 3)){
+			if(Position::from_fen(value, valueEnd, r.start)){
+				r.current = r.start;
+			} else {
+				r.error = true;
+			}
+		} else if(n == 6 && !memcmp(name, "Result", 6)){
+			r.result = parse_result(value, valueEnd);
+		}
+		return lineEnd;
+	}
+
+	static void replay_chunk(PgnChunk &chunk, int worker, const PgnVisitor &visit){
+		PgnReader r;
+		r.text = nullptr;
+		r.moves.reserve(PGN_RESERVE_PLY);
+		Position initial;
+		Position::from_fen(START_FEN, initial);
+		bool inMoves = false; // já houve texto de jogadas neste jogo
+
+		const char *c = chunk.begin, *end = chunk.end;
+		const char *last = c; // fim do último elemento do jogo atual
+		while(c < end){
+			char ch = *c;
+			if(is_space(ch)){
+				c++;
+				continue;
+			}
+			if(ch == '['){
+				// etiquetas depois de jogadas: jogo anterior sem resultado no fim
+				if(inMoves || !r.text){
+					end_game(r, last, worker, visit, chunk.stats);
+					begin_game(r, initial, c);
+					inMoves = false;
+				}
+				c = last = read_tag(r, c, end);
+				continue;
+			}
+			// comentários: fazem parte do jogo se estiverem dentro de um
+			if(ch == '{'){
+				const char *close = static_cast<const char *>(memchr(c, '}', end - c));
+				c = close ? close + 1 : end;
+				last = r.text ? c : last;
+				continue;
+			}
+			if(ch == ';' || (ch == '%' && (c == chunk.begin || c[-1] == '\n'))){
+				const char *nl = static_cast<const char *>(memchr(c, '\n', end - c));
+				c = nl ? nl : end;
+				last = r.text ? c : last;
+				continue;
+			}
+			if(!r.text){
+				begin_game(r, initial, c);
+			}
+			inMoves = true;
+
+			if(ch == '('){
+				c = last = skip_variation(c, end);
+			} else if(ch == ')'){
+				c = last = c + 1;
+			} else {
+				const char *t = c;
+				while(c < end && !is_space(*c) && *c != '{' && *c != '(' && *c != ')' && *c != ';' && *c != '['){
+					c++;
+				}
+				last = c;
+				if(*t == '*'){
+					end_game(r, last, worker, visit, chunk.stats);
+					inMoves = false;
+					continue;
+				}
+				if(*t == '$'){
+					continue;
+				}
+				if(*t >= '0' && *t <= '9'){
+					PgnResult result = parse_result(t, c);
+					if(result != PGN_RESULT_NONE){
+						r.result = result;
+						end_game(r, last, worker, visit, chunk.stats);
+						inMoves = false;
+						continue;
+					}
+					// número de jogada, "12." ou "12...", às vezes colado à jogada
+					while(t < c && !is_zero_castle(t, c) && ((*t >= '0' && *t <= '9') || *t == '.')){
+						t++;
+					}
+					if(t == c){
+						continue;
+					}
+				}
+				if(r.error){
+					continue;
+				}
+				Move m = san_to_move(r.current, t, c);
+				if(m == NO_MOVE){
+					r.error = true;
+					continue;
+				}
+				r.moves.push_back(m);
+				r.current.do_move(m, r.st);
+			}
+		}
+		end_game(r, last, worker, visit, chunk.stats);
+	}
+
+	PgnStats PgnFile::replay(ThreadPool &pool, const PgnVisitor &visit) const {
+		PgnStats total {};
+		const char *data = this->file.data();
+		const char *end = this->file.end();
+		size_t size = this->file.size();
+		if(!data){
+			return total;
+		}
+
+		int n = std::max(pool.size(), 1) * PGN_CHUNKS_PER_THREAD;
+		std::vector<PgnChunk> chunks;
+		chunks.reserve(n);
+		const char *begin = data;
+		for(int i = 1; i <= n && begin < end; i++){
+			const char *cut = i == n ? end : data + size / n * i;
+			if(cut <= begin){
+				continue;
+			}
+			cut = i == n ? end : next_game(cut, data, end);
+			chunks.push_back(PgnChunk{begin, cut, PgnStats{}});
+			begin = cut;
+		}
+
+		for(PgnChunk &chunk : chunks){
+			PgnChunk *ch = &chunk;
+			pool.submit([ch, &visit](int worker){ replay_chunk(*ch, worker, visit); });
+		}
+		pool.wait();
+
+		for(const PgnChunk &chunk : chunks){
+			total.games += chunk.stats.games;
+			total.moves += chunk.stats.moves;
+			total.errors += chunk.stats.errors;
+		}
+		return total;
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef PGN_HPP
+#define PGN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "chess.hpp"
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
+
+namespace chess {
+
+	enum PgnResult : int {
+		PGN_RESULT_NONE, // "*" ou sem resultado
+		PGN_WHITE_WINS,
+		PGN_BLACK_WINS,
+		PGN_DRAW,
+	};
+
+	// Um jogo já resolvido. Tudo o que aponta para fora (texto, jogadas) só é válido
+	// durante a chamada ao visitante: o texto é o próprio ficheiro mapeado e as jogadas
+	// estão num buffer da thread que é reutilizado no jogo seguinte.
+	struct PgnGame {
+		const char *text;   // etiquetas e jogadas, tal como estão no ficheiro
+		size_t length;
+		Position start;     // etiqueta FEN, ou a posição inicial
+		const Move *moves;
+		int moveCount;
+		PgnResult result;
+	};
+
+	struct PgnStats {
+		uint64_t games;
+		uint64_t moves;
+		uint64_t errors; // jogos deixados a meio: FEN inválida ou jogada que não se resolve
+	};
+
+	// recebe o índice da thread do pool que o chama, como ThreadPool::Task
+	typedef std::function<void(int, const PgnGame &)> PgnVisitor;
+
+	// SAN ("Nbxd7+", "exd6", "e8=Q", "O-O-O", "0-0") em [begin, end) para uma jogada legal de pos;
+	// NO_MOVE se não corresponder a nenhuma. Ignora +, #, ! e ? no fim.
+	Move san_to_move(const Position &pos, const char *begin, const char *end);
+
+	// Ficheiro PGN mapeado em memória. O texto é percorrido sem cópias: as etiquetas
+	// só interessam FEN e Result; comentários, variantes, NAG e números de jogada saltam-se.
+	class PgnFile {
+		MappedFile file;
+
+		public:
+		explicit PgnFile(const char *path): file{path} {}
+
+		bool is_open(void) const { return this->file.is_open(); }
+		size_t bytes(void) const { return this->file.size(); }
+
+		// Divide o ficheiro em blocos que começam no início de um jogo e dá-os às threads
+		// de pool; cada uma repete os seus jogos e chama visit uma vez por jogo, com as
+		// jogadas já resolvidas. A ordem das chamadas entre blocos não é a do ficheiro.
+		// Os jogos com erro não são visitados.
+		PgnStats replay(ThreadPool &pool, const PgnVisitor &visit) const;
+	};
+}
+
+#endif // PGN_HPP
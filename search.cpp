@@ -0,0 +1,656 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <thread>
+#include "alloc.hpp"
+#include "evaluate.hpp"
+#include "movepick.hpp"
+#include "search.hpp"
+#include "tablebase.hpp"
+
+namespace chess {
+
+	// o que a posição ainda pode ganhar sem ser em material (quiescência)
+	constexpr int DELTA_MARGIN { 200 };
+	// margem (ms) para a comunicação com a interface não fazer perder por tempo
+	constexpr int64_t MOVE_OVERHEAD { 30 };
+
+	static int value_to_tt(int v, int ply);
+	static int value_from_tt(int v, int ply);
+	static int lmr_reduction(int depth, int moveCount);
+	static int tb_value(TbWdl wdl, int dtm, int ply);
+
+	// os mates guardam-se relativos ao nó, não à raiz
+	static int value_to_tt(int v, int ply){
+		return v >= VALUE_MATE_IN_MAX_PLY ? v + ply : v <= -VALUE_MATE_IN_MAX_PLY ? v - ply : v;
+	}
+	static int value_from_tt(int v, int ply){
+		return v >= VALUE_MATE_IN_MAX_PLY ? v - ply : v <= -VALUE_MATE_IN_MAX_PLY ? v + ply : v;
+	}
+
+	// mate exato se couber na pesquisa; senão uma vitória certa, igual em qualquer ply
+	static int tb_value(TbWdl wdl, int dtm, int ply){
+		if(wdl == TB_DRAW){
+			return VALUE_DRAW;
+		}
+		int v = ply + dtm < MAX_PLY ? VALUE_MATE - ply - dtm : VALUE_MATE_IN_MAX_PLY - 1;
+		return wdl == TB_WIN ? v : -v;
+	}
+
+	static int lmr_reduction(int depth, int moveCount){
+		static const std::array<std::array<int, 64>, 64> table = []{
+			std::array<std::array<int, 64>, 64> t {};
+			for(int d = 1; d < 64; d++){
+				for(int m = 1; m < 64; m++){
+					t[d][m] = int(0.75 + std::log(d) * std::log(m) / 2.25);
+				}
+			}
+			return t;
+		}();
+		return table[depth < 63 ? depth : 63][moveCount < 63 ? moveCount : 63];
+	}
+
+	// Lazy SMP: a thread auxiliar i salta as profundidades em que
+	// ((profundidade + SKIP_PHASE) / SKIP_SIZE) é ímpar, para as threads
+	// ficarem espalhadas por profundidades diferentes
+	constexpr int SKIP_N { 20 };
+	static const int SKIP_SIZE[SKIP_N] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+	static const int SKIP_PHASE[SKIP_N] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+	SearchThread::SearchThread(Search &s, int index): owner{s}, id{index}, nodes{0}, seldepth{0}, rootDepth{0},
+	                                                  completedDepth{0}, bestScore{-VALUE_INFINITE}, bestMove{NO_MOVE},
+	                                                  lineCount{0}, pvIdx{0}, rootMoveCount{0}, useNnue{false}, tbMen{0} {
+		this->keys.reserve(MAX_HISTORY_KEYS + MAX_PLY + 2);
+	}
+
+	void SearchThread::count_node(void){
+		uint64_t n = this->nodes + 1;
+		__atomic_store_n(&this->nodes, n, __ATOMIC_RELAXED);
+		// só a thread principal olha para o relógio
+		if(this->id == 0 && (n & 1023) == 0){
+			this->owner.check_limits();
+		}
+	}
+
+	bool SearchThread::stopped(void) const {
+		return this->owner.stopFlag.load(std::memory_order_relaxed);
+	}
+
+	bool SearchThread::is_repetition(int ply) const {
+		uint64_t k = this->keys.back();
+		int n = int(this->keys.size()) - 1;
+		int limit = this->stack[ply].reversible < n ? this->stack[ply].reversible : n;
+		for(int i = 4; i <= limit; i += 2){
+			if(this->keys[n - i] == k){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool SearchThread::excluded_at_root(Move m) const {
+		for(int i = 0; i < this->pvIdx; i++){
+			if(this->lines[i].pv[0] == m){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void SearchThread::update_pv(int ply, Move m){
+		SearchStack &ss = this->stack[ply];
+		const SearchStack &next = this->stack[ply + 1];
+		ss.pv[0] = m;
+		std::copy(next.pv.begin(), next.pv.begin() + next.pvLength, ss.pv.begin() + 1);
+		ss.pvLength = next.pvLength + 1;
+	}
+
+	int SearchThread::static_eval(int ply){
+		return evaluate(this->pos, this->pawns, this->useNnue ? &this->accumulators[ply] : nullptr);
+	}
+
+	void SearchThread::play(Move m, StateInfo &st, int ply){
+		if(!this->useNnue){
+			this->pos.do_move(m, st);
+			return;
+		}
+		DirtyPieces dp;
+		nnue_dirty_pieces(this->pos, m, dp);
+		this->pos.do_move(m, st);
+		nnue_update(this->pos, dp, this->accumulators[ply], this->accumulators[ply + 1]);
+	}
+
+	int SearchThread::qsearch(int alpha, int beta, int ply){
+		this->count_node();
+		if(this->stopped()){
+			return 0;
+		}
+		if(ply > this->seldepth){
+			this->seldepth = ply;
+		}
+		if(ply >= MAX_PLY){
+			return this->static_eval(ply);
+		}
+
+		bool inCheck = this->pos.in_check();
+		int best = -VALUE_INFINITE;
+		if(!inCheck){
+			best = this->static_eval(ply);
+			if(best >= beta){
+				return best;
+			}
+			if(best > alpha){
+				alpha = best;
+			}
+		}
+
+		// em xeque procuram-se todas as defesas, o que também deteta o mate
+		TTData tte;
+		Move ttMove = this->owner.tt.probe(this->pos.get_key(), tte, &this->ttStats) ? tte.move : NO_MOVE;
+		SearchStack &ss = this->stack[ply];
+		MovePicker mp(this->pos, ss.moves, ttMove, this->history);
+		int moveCount = 0;
+
+		Move m;
+		while(move_type(m = mp.next()) != MOVE_NONE){
+			moveCount++;
+			if(!inCheck){
+				// poda delta: nem ganhando a peça de graça se chega a alpha
+				if(move_type(m) != MOVE_PROMOTION &&
+				   best + PIECE_VALUE[piece_type(this->pos.captured_piece(m))] + DELTA_MARGIN <= alpha){
+					continue;
+				}
+				// capturas que perdem material não mudam o resultado
+				if(!this->pos.see_ge(m, 0)){
+					continue;
+				}
+			}
+			this->play(m, ss.st, ply);
+			int v = -this->qsearch(-beta, -alpha, ply + 1);
+			this->pos.undo_move(m, ss.st);
+
+			if(this->stopped()){
+				return 0;
+			}
+			if(v > best){
+				best = v;
+				if(v > alpha){
+					alpha = v;
+					if(v >= beta){
+						break;
+					}
+				}
+			}
+		}
+		if(inCheck && moveCount == 0){
+			return -VALUE_MATE + ply;
+		}
+		return best;
+	}
+
+	int SearchThread::search(int alpha, int beta, int depth, int ply, bool pvNode){
+		SearchStack &ss = this->stack[ply];
+		ss.pvLength = 0;
+		if(depth <= 0){
+			return this->qsearch(alpha, beta, ply);
+		}
+		this->count_node();
+		if(this->stopped()){
+			return 0;
+		}
+
+		if(ply > this->seldepth){
+			this->seldepth = ply;
+		}
+
+		if(ply > 0){
+			if(this->is_repetition(ply)){
+				return VALUE_DRAW;
+			}
+			if(ply >= MAX_PLY - 1){
+				return this->static_eval(ply);
+			}
+			// não vale a pena procurar mates mais longos do que um já encontrado
+			alpha = std::max(alpha, -VALUE_MATE + ply);
+			beta = std::min(beta, VALUE_MATE - ply - 1);
+			if(alpha >= beta){
+				return alpha;
+			}
+			TbWdl wdl;
+			int dtm;
+			if(this->pos.pieces().popcount() <= this->tbMen && tb_probe(this->pos, wdl, dtm)){
+				return tb_value(wdl, dtm, ply);
+			}
+		}
+
+		uint64_t key = this->pos.get_key();
+		TTData tte;
+		bool ttHit = this->owner.tt.probe(key, tte, &this->ttStats);
+		Move ttMove = ttHit ? tte.move : NO_MOVE;
+		if(ttHit && !pvNode && tte.depth >= depth){
+			int v = value_from_tt(tte.score, ply);
+			if(tte.bound == BOUND_EXACT ||
+			   (tte.bound == BOUND_LOWER && v >= beta) ||
+			   (tte.bound == BOUND_UPPER && v <= alpha)){
+				return v;
+			}
+		}
+
+		bool inCheck = this->pos.in_check();
+		ss.staticEval = inCheck ? -VALUE_INFINITE : this->static_eval(ply);
+
+		// jogada nula: se mesmo passando a vez o adversário não chega a beta, corta-se
+		if(!pvNode && ply > 0 && !inCheck && depth >= 3 && ss.staticEval >= beta &&
+		   move_type(this->stack[ply - 1].currentMove) != MOVE_NONE &&
+		   this->pos.has_non_pawn_material(this->pos.side_to_move())){
+			int r = 3 + depth / 4;
+			ss.currentMove = NO_MOVE;
+			this->pos.do_null_move(ss.st);
+			if(this->useNnue){
+				this->accumulators[ply + 1] = this->accumulators[ply];
+			}
+			this->keys.push_back(this->pos.get_key());
+			this->stack[ply + 1].reversible = 0;
+			int v = -this->search(-beta, -beta + 1, depth - 1 - r, ply + 1, false);
+			this->keys.pop_back();
+			this->pos.undo_null_move(ss.st);
+
+			if(this->stopped()){
+				return 0;
+			}
+			if(v >= beta){
+				return v >= VALUE_MATE_IN_MAX_PLY ? beta : v;
+			}
+		}
+
+		if(ply + 2 <= MAX_PLY){
+			this->stack[ply + 2].killers.fill(NO_MOVE);
+		}
+		Move prev = ply > 0 ? this->stack[ply - 1].currentMove : NO_MOVE;
+		Move counter = move_type(prev) != MOVE_NONE ?
+		               this->counterMoves[piece_index(this->pos.get_piece(move_dst(prev)))][move_dst(prev)] : NO_MOVE;
+		MovePicker mp(this->pos, ss.moves, ttMove, ss.killers.data(), counter, this->history);
+
+		int alphaOrig = alpha;
+		int best = -VALUE_INFINITE;
+		Move bestMove = NO_MOVE;
+		int moveCount = 0;
+		ss.quietCount = 0;
+
+		Move m;
+		while(move_type(m = mp.next()) != MOVE_NONE){
+			if(ply == 0 && this->excluded_at_root(m)){
+				continue;
+			}
+			int i = moveCount++;
+			bool quiet = !this->pos.is_capture(m) && move_type(m) != MOVE_PROMOTION;
+			bool irreversible = !quiet || piece_type(this->pos.get_piece(move_src(m))) == PIECE_PAWN;
+
+			this->owner.tt.prefetch(this->pos.key_after(m));
+			ss.currentMove = m;
+			this->play(m, ss.st, ply);
+			this->keys.push_back(this->pos.get_key());
+			this->stack[ply + 1].reversible = irreversible ? 0 : ss.reversible + 1;
+
+			bool givesCheck = this->pos.in_check();
+			int newDepth = depth - 1 + (givesCheck ? 1 : 0);
+			int v;
+
+			// PVS: a primeira jogada com janela inteira, as outras com janela nula,
+			// reduzidas se forem tardias e calmas (LMR)
+			if(i == 0){
+				v = -this->search(-beta, -alpha, newDepth, ply + 1, pvNode);
+			} else {
+				int r = 0;
+				if(depth >= 3 && i >= 3 && quiet && !inCheck && !givesCheck){
+					r = lmr_reduction(depth, i) - (pvNode ? 1 : 0);
+					r = std::max(0, std::min(r, newDepth - 1));
+				}
+				v = -this->search(-alpha - 1, -alpha, newDepth - r, ply + 1, false);
+				if(v > alpha && r > 0){
+					v = -this->search(-alpha - 1, -alpha, newDepth, ply + 1, false);
+				}
+				if(v > alpha && v < beta && pvNode){
+					v = -this->search(-beta, -alpha, newDepth, ply + 1, true);
+				}
+			}
+
+			this->keys.pop_back();
+			this->pos.undo_move(m, ss.st);
+
+			if(this->stopped()){
+				return 0;
+			}
+			if(v > best){
+				best = v;
+				if(v > alpha){
+					bestMove = m;
+					alpha = v;
+					if(pvNode){
+						this->update_pv(ply, m);
+					}
+					if(v >= beta){
+						if(quiet){
+							this->update_quiet_stats(ply, depth, m);
+						}
+						break;
+					}
+				}
+			}
+			if(quiet && ss.quietCount < int(ss.quietsTried.size())){
+				ss.quietsTried[ss.quietCount++] = m;
+			}
+		}
+
+		if(moveCount == 0){
+			return inCheck ? -VALUE_MATE + ply : VALUE_DRAW;
+		}
+
+		Bound b = best >= beta ? BOUND_LOWER : best > alphaOrig ? BOUND_EXACT : BOUND_UPPER;
+		this->owner.tt.store(key, bestMove, value_to_tt(best, ply), depth, b, &this->ttStats);
+		return best;
+	}
+
+	void SearchThread::update_quiet_stats(int ply, int depth, Move m){
+		SearchStack &ss = this->stack[ply];
+		if(ss.killers[0] != m){
+			ss.killers[1] = ss.killers[0];
+			ss.killers[0] = m;
+		}
+		Move prev = ply > 0 ? this->stack[ply - 1].currentMove : NO_MOVE;
+		if(move_type(prev) != MOVE_NONE){
+			this->counterMoves[piece_index(this->pos.get_piece(move_dst(prev)))][move_dst(prev)] = m;
+		}
+
+		auto &h = this->history[this->pos.side_to_move()];
+		int bonus = std::min(32 * depth * depth, 1600);
+		history_update(h[move_src(m)][move_dst(m)], bonus);
+		for(int i = 0; i < ss.quietCount; i++){
+			Move q = ss.quietsTried[i];
+			history_update(h[move_src(q)][move_dst(q)], -bonus);
+		}
+	}
+
+	void SearchThread::clear(void){
+		for(auto &byColor : this->history){
+			for(auto &bySrc : byColor){
+				bySrc.fill(0);
+			}
+		}
+		for(auto &byPiece : this->counterMoves){
+			byPiece.fill(NO_MOVE);
+		}
+		this->pawns.clear();
+	}
+
+	void SearchThread::setup(const Position &root, const std::vector<uint64_t> &history){
+		this->pos = root;
+		__atomic_store_n(&this->nodes, 0, __ATOMIC_RELAXED);
+		this->ttStats = TTStats();
+		this->pawns.reset_stats();
+		this->seldepth = 0;
+		this->rootDepth = 0;
+		this->completedDepth = 0;
+		this->bestScore = -VALUE_INFINITE;
+		this->useNnue = nnue_enabled();
+		if(this->useNnue){
+			nnue_refresh(this->pos, this->accumulators[0]);
+		}
+		this->tbMen = tb_max_men();
+
+		for(SearchStack &ss : this->stack){
+			ss.killers.fill(NO_MOVE);
+		}
+
+		// cabe na capacidade reservada: nem aqui nem na pesquisa se pede memória
+		size_t n = std::min(history.size(), size_t(MAX_HISTORY_KEYS));
+		this->keys.assign(history.end() - n, history.end());
+		this->keys.push_back(root.get_key());
+		this->stack[0].reversible = int(n);
+
+		MoveList rootMoves;
+		this->pos.generate_legal(rootMoves);
+		this->bestMove = rootMoves.size() ? rootMoves[0] : NO_MOVE;
+		this->rootMoveCount = rootMoves.size();
+		this->pvIdx = 0;
+	}
+
+	// tudo o que a pesquisa usa está em this->stack e nas tabelas da thread: com
+	// CHESS_DEBUG confirma-se no fim que nada foi pedido ao operator new
+	void SearchThread::iterate(void){
+		uint64_t allocations = thread_allocations();
+		int limit = this->owner.limits.depth;
+		int maxDepth = limit > 0 && limit < MAX_PLY ? limit : MAX_PLY - 1;
+		// as auxiliares só ajudam a melhor linha
+		int multiPV = this->id == 0 ? std::min(std::max(this->owner.limits.multiPV, 1), this->rootMoveCount) : 1;
+		this->lineCount = multiPV;
+		for(int i = 0; i < multiPV; i++){
+			this->lines[i].score = 0;
+			this->lines[i].pvLength = 0;
+		}
+
+		for(int depth = 1; depth <= maxDepth; depth++){
+			if(this->id > 0){
+				int i = (this->id - 1) % SKIP_N;
+				if(((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2){
+					continue;
+				}
+			}
+			this->rootDepth = depth;
+			this->seldepth = 0;
+
+			for(this->pvIdx = 0; this->pvIdx < multiPV; this->pvIdx++){
+				RootLine &line = this->lines[this->pvIdx];
+
+				// janela de aspiração à volta do valor anterior, alargada quando falha
+				int delta = 25;
+				int alpha = -VALUE_INFINITE, beta = VALUE_INFINITE;
+				if(depth >= 4 && this->completedDepth > 0){
+					alpha = std::max(line.score - delta, -VALUE_INFINITE);
+					beta = std::min(line.score + delta, VALUE_INFINITE);
+				}
+				int v;
+				for(;;){
+					v = this->search(alpha, beta, depth, 0, true);
+					if(this->stopped()){
+						break;
+					}
+					if(v <= alpha){
+						beta = (alpha + beta) / 2;
+						alpha = std::max(v - delta, -VALUE_INFINITE);
+					} else if(v >= beta){
+						beta = std::min(v + delta, VALUE_INFINITE);
+					} else {
+						break;
+					}
+					delta += delta / 2;
+				}
+				if(this->stopped()){
+					break;
+				}
+
+				line.score = v;
+				line.pvLength = this->stack[0].pvLength;
+				std::copy(this->stack[0].pv.begin(), this->stack[0].pv.begin() + line.pvLength, line.pv.begin());
+				// mantém lines[0, pvIdx] por ordem: a nova linha sobe enquanto for
+				// melhor (estável, e sem o buffer que std::stable_sort pediria)
+				for(int i = this->pvIdx; i > 0 && this->lines[i].score > this->lines[i - 1].score; i--){
+					std::swap(this->lines[i], this->lines[i - 1]);
+				}
+			}
+			if(this->stopped()){
+				break;
+			}
+
+			this->bestScore = this->lines[0].score;
+			this->completedDepth = depth;
+			if(this->lines[0].pvLength > 0){
+				this->bestMove = this->lines[0].pv[0];
+			}
+			if(this->id == 0){
+				this->owner.report(*this);
+				if(this->owner.past_optimum()){
+					break;
+				}
+			}
+		}
+		assert(thread_allocations() == allocations);
+		(void)allocations;
+	}
+
+	Search::Search(TranspositionTable &table, int nThreads): tt{table}, stopFlag{false}, pondering{false},
+	                                                          optimumMs{0}, maximumMs{0} {
+		this->set_threads(nThreads);
+	}
+
+	void Search::clear(void){
+		for(auto &t : this->threads){
+			t->clear();
+		}
+	}
+
+	Search::~Search(void){}
+
+	void Search::set_threads(int n){
+		n = n < 1 ? 1 : n;
+		this->pool.reset(n > 1 ? new ThreadPool(n - 1) : nullptr);
+		this->threads.clear();
+		for(int i = 0; i < n; i++){
+			this->threads.emplace_back(new SearchThread(*this, i));
+			this->threads.back()->clear();
+		}
+	}
+
+	int64_t Search::elapsed_ms(void) const {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - this->startTime).count();
+	}
+
+	void Search::check_limits(void){
+		// a primeira iteração acaba sempre, para haver uma jogada
+		if(this->threads[0]->rootDepth <= 1){
+			return;
+		}
+		if(this->limits.nodes && this->node_count() >= this->limits.nodes){
+			this->stopFlag = true;
+		}
+		if(this->pondering){
+			return;
+		}
+		int64_t t = this->elapsed_ms();
+		if((this->limits.movetime && t >= this->limits.movetime) || (this->maximumMs && t >= this->maximumMs)){
+			this->stopFlag = true;
+		}
+	}
+
+	// cada iteração custa mais do que todas as anteriores juntas: passada metade
+	// do tempo alvo, a próxima quase de certeza não acabava a tempo
+	bool Search::past_optimum(void) const {
+		return !this->pondering && this->optimumMs && this->elapsed_ms() >= this->optimumMs / 2;
+	}
+
+	void Search::report(const SearchThread &main){
+		if(!this->reporter){
+			return;
+		}
+		int64_t t = this->elapsed_ms();
+		SearchReport r;
+		r.depth = main.completedDepth;
+		r.seldepth = main.seldepth;
+		r.nodes = this->node_count();
+		r.timeMs = t;
+		r.nps = t > 0 ? r.nodes * 1000 / uint64_t(t) : 0;
+		r.hashfull = this->tt.hashfull();
+		for(int i = 0; i < main.lineCount; i++){
+			r.score = main.lines[i].score;
+			r.pv = main.lines[i].pv.data();
+			r.pvLength = main.lines[i].pvLength;
+			r.multipv = i + 1;
+			this->reporter(r);
+		}
+	}
+
+	uint64_t Search::node_count(void) const {
+		uint64_t n = 0;
+		for(const auto &t : this->threads){
+			n += t->node_count();
+		}
+		return n;
+	}
+
+	TTStats Search::tt_stats(void) const {
+		TTStats s;
+		for(const auto &t : this->threads){
+			s += t->ttStats;
+		}
+		return s;
+	}
+
+	PawnStats Search::pawn_stats(void) const {
+		PawnStats s;
+		for(const auto &t : this->threads){
+			s += t->pawns.get_stats();
+		}
+		return s;
+	}
+
+	void Search::start(const Position &root, const SearchLimits &lim, const std::vector<uint64_t> &history){
+		this->limits = lim;
+		this->stopFlag = false;
+		this->pondering = lim.ponder;
+		this->startTime = Clock::now();
+		this->tt.new_search();
+
+		// com relógio: uma fração do que resta mais a maior parte do incremento
+		this->optimumMs = this->maximumMs = 0;
+		PieceColor us = root.side_to_move();
+		if(lim.time[us] > 0){
+			int movesToGo = lim.movestogo > 0 ? std::min(lim.movestogo, 50) : 30;
+			int64_t left = std::max<int64_t>(lim.time[us] - MOVE_OVERHEAD, 1);
+			this->optimumMs = std::min(left / movesToGo + lim.inc[us] * 3 / 4, left);
+			this->maximumMs = std::min(this->optimumMs * 4, left);
+		}
+
+		for(auto &t : this->threads){
+			t->setup(root, history);
+		}
+	}
+
+	Move Search::run(void){
+		if(this->threads[0]->bestMove == NO_MOVE){
+			return NO_MOVE;
+		}
+
+		for(size_t i = 1; i < this->threads.size(); i++){
+			SearchThread *t = this->threads[i].get();
+			this->pool->submit([t](int){ t->iterate(); });
+		}
+		this->threads[0]->iterate();
+
+		// em modo infinito ou a pensar no tempo do adversário, a resposta só sai
+		// quando mandarem, mesmo que a pesquisa tenha acabado antes
+		while(!this->stopFlag && (this->limits.infinite || this->pondering)){
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		// a principal acabou: as auxiliares param também
+		this->stopFlag = true;
+		if(this->pool){
+			this->pool->wait();
+		}
+
+		// uma auxiliar só ganha se acabou uma iteração mais funda e com melhor valor
+		const SearchThread *best = this->threads[0].get();
+		for(size_t i = 1; i < this->threads.size(); i++){
+			const SearchThread *t = this->threads[i].get();
+			if(t->completedDepth > best->completedDepth && t->bestScore > best->bestScore){
+				best = t;
+			}
+		}
+		return best->bestMove;
+	}
+
+	Move Search::think(const Position &root, const SearchLimits &lim, const std::vector<uint64_t> &history){
+		this->start(root, lim, history);
+		return this->run();
+	}
+}
@@ -0,0 +1,218 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "chess.hpp"
+#include "movepick.hpp"
+#include "nnue.hpp"
+#include "pawns.hpp"
+#include "threadpool.hpp"
+#include "tt.hpp"
+
+namespace chess {
+
+	constexpr int MAX_PLY { 128 };
+	constexpr int VALUE_DRAW { 0 };
+	constexpr int VALUE_MATE { 32000 };
+	constexpr int VALUE_INFINITE { 32001 };
+	constexpr int VALUE_MATE_IN_MAX_PLY { VALUE_MATE - MAX_PLY };
+	constexpr int MAX_MULTIPV { 64 };
+	// posições anteriores à raiz guardadas para as repetições (as mais antigas perdem-se)
+	constexpr int MAX_HISTORY_KEYS { 1024 };
+
+	// zero significa "sem limite"
+	struct SearchLimits {
+		int depth;
+		int64_t movetime; // ms
+		uint64_t nodes;
+		// relógio de jogo (ms), por cor; o tempo da jogada calcula-se a partir daqui
+		int64_t time[PIECE_N_COLORS];
+		int64_t inc[PIECE_N_COLORS];
+		int movestogo;
+		// só para quando mandarem (stop), mesmo que chegue à profundidade máxima
+		bool infinite;
+		// a pensar no tempo do adversário: o relógio só conta depois de ponderhit()
+		bool ponder;
+		// quantas das melhores jogadas da raiz procurar e reportar
+		int multiPV;
+
+		SearchLimits(void): depth{0}, movetime{0}, nodes{0}, time{0, 0}, inc{0, 0}, movestogo{0},
+		                    infinite{false}, ponder{false}, multiPV{1} {}
+	};
+
+	// enviado no fim de cada iteração
+	struct SearchReport {
+		int depth;
+		int seldepth;
+		int score;
+		uint64_t nodes;
+		int64_t timeMs;
+		uint64_t nps;
+		int hashfull;
+		const Move *pv;
+		int pvLength;
+		int multipv; // 1 para a melhor linha
+	};
+
+	struct RootLine {
+		int score;
+		int pvLength;
+		std::array<Move, MAX_PLY + 1> pv;
+	};
+
+	// O que a pesquisa guarda por ply. A pilha é reservada uma vez com a thread e
+	// reaproveitada de pesquisa para pesquisa: a pesquisa em si não pede memória.
+	struct SearchStack {
+		Move currentMove;
+		std::array<Move, 2> killers;
+		int staticEval;
+		// meios-lances desde a última jogada irreversível (ou jogada nula)
+		int reversible;
+		StateInfo st;
+		// calmas já tentadas, para lhes baixar o histórico se outra cortar
+		std::array<Move, 64> quietsTried;
+		int quietCount;
+		std::array<Move, MAX_PLY + 1> pv;
+		int pvLength;
+		MoveBuffer moves;
+	};
+
+	class Search;
+
+	// Estado de uma thread de pesquisa. Cada uma tem a sua cópia da posição e das
+	// tabelas; só a tabela de transposição e o sinal de paragem são partilhados.
+	class SearchThread {
+		Search &owner;
+		int id;
+
+		Position pos;
+		TTStats ttStats;
+		PawnTable pawns;
+		// escrito só por esta thread, lido pelas outras com __atomic_load_n
+		uint64_t nodes;
+		int seldepth;
+		int rootDepth;
+		int completedDepth;
+		int bestScore;
+		Move bestMove;
+
+		// chaves das posições desde o início do jogo, para detetar repetições;
+		// capacidade reservada no construtor
+		std::vector<uint64_t> keys;
+		// stack[ply]; os dois a mais são para o ply seguinte ao último
+		std::array<SearchStack, MAX_PLY + 2> stack;
+
+		// MultiPV: a linha pvIdx procura-se sem as primeiras jogadas de lines[0, pvIdx)
+		std::array<RootLine, MAX_MULTIPV> lines;
+		int lineCount;
+		int pvIdx;
+		int rootMoveCount;
+
+		// ordenação das jogadas; cada thread tem as suas para não disputarem linhas de cache
+		ButterflyHistory history;
+		CounterMoves counterMoves;
+
+		// avaliação por rede: lida de nnue_enabled() no início de cada pesquisa;
+		// accumulators[ply] corresponde à posição em ply
+		bool useNnue;
+		std::array<Accumulator, MAX_PLY + 2> accumulators;
+		// tabelas de finais: posições com até tbMen peças resolvem-se sem pesquisa
+		// (0 sem tabelas); lido de tb_max_men() no início de cada pesquisa
+		int tbMen;
+
+		int search(int alpha, int beta, int depth, int ply, bool pvNode);
+		int qsearch(int alpha, int beta, int ply);
+		bool is_repetition(int ply) const;
+		bool excluded_at_root(Move m) const;
+		void update_pv(int ply, Move m);
+		int static_eval(int ply);
+		// do_move que também prepara o acumulador de ply + 1
+		void play(Move m, StateInfo &st, int ply);
+		void update_quiet_stats(int ply, int depth, Move m);
+		void count_node(void);
+		bool stopped(void) const;
+
+		friend class Search;
+
+		public:
+		SearchThread(Search &s, int index);
+
+		// esquece o histórico, as contra-jogadas e a tabela de peões (novo jogo)
+		void clear(void);
+		void setup(const Position &root, const std::vector<uint64_t> &history);
+		// aprofundamento iterativo até ao limite de profundidade ou até parar
+		void iterate(void);
+
+		uint64_t node_count(void) const { return __atomic_load_n(&this->nodes, __ATOMIC_RELAXED); }
+	};
+
+	// Lazy SMP: todas as threads fazem a mesma pesquisa na mesma raiz, partilhando
+	// a tabela de transposição. As auxiliares saltam profundidades de forma
+	// desencontrada para não andarem todas pelos mesmos nós.
+	class Search {
+		typedef std::chrono::steady_clock Clock;
+
+		TranspositionTable &tt;
+		SearchLimits limits;
+		std::atomic<bool> stopFlag;
+		Clock::time_point startTime;
+
+		// threads[0] corre na thread de quem chama think(), as outras na pool
+		std::vector<std::unique_ptr<SearchThread>> threads;
+		std::unique_ptr<ThreadPool> pool;
+
+		std::function<void(const SearchReport &)> reporter;
+
+		// pondering é limpo por ponderhit() de outra thread
+		std::atomic<bool> pondering;
+		// tempo da jogada (ms) tirado do relógio: o alvo e o máximo absoluto
+		int64_t optimumMs;
+		int64_t maximumMs;
+
+		void check_limits(void);
+		// o aprofundamento iterativo não começa outra iteração depois disto
+		bool past_optimum(void) const;
+		void report(const SearchThread &main);
+		int64_t elapsed_ms(void) const;
+
+		friend class SearchThread;
+
+		public:
+		explicit Search(TranspositionTable &table, int nThreads = 1);
+		~Search(void);
+
+		void set_reporter(std::function<void(const SearchReport &)> f){
+			this->reporter = f;
+		}
+		void set_threads(int n);
+		// esquece o que as threads aprenderam para ordenar jogadas (novo jogo)
+		void clear(void);
+		int thread_count(void) const { return int(this->threads.size()); }
+
+		// history: chaves das posições anteriores à raiz, da mais antiga para a mais recente
+		Move think(const Position &root, const SearchLimits &lim,
+		           const std::vector<uint64_t> &history = std::vector<uint64_t>());
+		// think() em dois passos, para correr a pesquisa noutra thread: depois de
+		// start() um stop() já não se perde, mesmo que run() ainda não tenha começado
+		void start(const Position &root, const SearchLimits &lim,
+		           const std::vector<uint64_t> &history = std::vector<uint64_t>());
+		Move run(void);
+		// podem ser chamados de outra thread
+		void stop(void){ this->stopFlag = true; }
+		// o adversário jogou a jogada prevista: a pesquisa passa a contar o tempo
+		void ponderhit(void){ this->pondering = false; }
+
+		// somas de todas as threads
+		uint64_t node_count(void) const;
+		TTStats tt_stats(void) const;
+		PawnStats pawn_stats(void) const;
+	};
+}
+
+#endif // SEARCH_HPP
@@ -0,0 +1,738 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "attacks.hpp"
+#include "mappedfile.hpp"
+#include "tablebase.hpp"
+
+namespace chess {
+
+	constexpr int TB_KING_PAIRS { 462 };
+	constexpr int TB_PAWN_KING_PAIRS { 32 * 64 };
+	constexpr int TB_PAWN_SQUARES { 48 };
+	constexpr size_t TB_HEADER_BYTES { 24 };
+	constexpr size_t TB_NAME_MAX { 8 };
+	constexpr int TB_CHUNKS_PER_THREAD { 16 };
+	constexpr uint64_t TB_NO_INDEX { ~uint64_t(0) };
+	constexpr uint8_t TB_EXIT_DRAW { 255 };
+	// ordem das peças de cada cor, no nome e no índice, depois do rei
+	constexpr std::array<PieceType, 5> TB_ORDER { PIECE_QUEEN, PIECE_ROOK, PIECE_BISHOP, PIECE_KNIGHT, PIECE_PAWN };
+	constexpr char TB_LETTER[PIECE_N_TYPES] { 'P', 'N', 'B', 'R', 'Q', 'K' };
+
+	// t: bit 2 troca colunas com linhas, depois bit 0 espelha as colunas e bit 1 as linhas
+	constexpr int sym_square(int sq, int t){
+		if(t & 4){
+			sq = (sq & 7) << 3 | sq >> 3;
+		}
+		if(t & 1){
+			sq ^= 7;
+		}
+		if(t & 2){
+			sq ^= 56;
+		}
+		return sq;
+	}
+
+	// Pares de reis sem peões: o branco no triângulo a1-d1-d4 e, se estiver na
+	// diagonal a1-h8, o preto na diagonal ou abaixo dela; reis nunca juntos.
+	struct KingPairs {
+		int16_t index[SQUARE_COUNT][SQUARE_COUNT]; // -1 se o par não for canónico
+		uint8_t sym[SQUARE_COUNT][SQUARE_COUNT];   // simetria que leva o par ao canónico
+		uint8_t list[TB_KING_PAIRS][2];
+		int count;
+	};
+
+	constexpr bool king_pair_canonical(int wk, int bk){
+		int wf = wk & 7, wr = wk >> 3, bf = bk & 7, br = bk >> 3;
+		if(wf > 3 || wr > wf || (wr == wf && br > bf)){
+			return false;
+		}
+		return (wf - bf) * (wf - bf) > 1 || (wr - br) * (wr - br) > 1;
+	}
+
+	constexpr KingPairs KING_PAIRS = []{
+		KingPairs kp {};
+		for(int wk = 0; wk < SQUARE_COUNT; wk++){
+			for(int bk = 0; bk < SQUARE_COUNT; bk++){
+				kp.index[wk][bk] = -1;
+				// a identidade vem primeiro: um par canónico fica como está
+				for(int t = 0; t < 8; t++){
+					if(king_pair_canonical(sym_square(wk, t), sym_square(bk, t))){
+						kp.sym[wk][bk] = uint8_t(t);
+						break;
+					}
+				}
+				if(king_pair_canonical(wk, bk) && kp.count < TB_KING_PAIRS){
+					kp.index[wk][bk] = int16_t(kp.count);
+					kp.list[kp.count][0] = uint8_t(wk);
+					kp.list[kp.count][1] = uint8_t(bk);
+					kp.count++;
+				}
+			}
+		}
+		return kp;
+	}();
+	static_assert(KING_PAIRS.count == TB_KING_PAIRS, "devia haver 462 pares de reis");
+
+	// Ordem das peças no índice: rei branco, rei preto, as outras brancas e depois as
+	// outras pretas, por TB_ORDER. As cores são as da tabela (a mais forte é a branca).
+	struct TbLayout {
+		int n;
+		Piece piece[TB_MAX_MEN];
+		bool pawns;
+		uint64_t entries;
+		uint64_t signature;
+		char name[TB_NAME_MAX];
+	};
+
+	struct TbTable {
+		TbLayout layout;
+		MappedFile file;
+		const uint8_t *values;
+
+		explicit TbTable(const char *path): layout{}, file{path, false}, values{nullptr} {}
+	};
+
+	// durante a geração as threads escrevem em values ao mesmo tempo
+	struct TbGen {
+		const TbLayout &layout;
+		std::unique_ptr<std::atomic<uint8_t>[]> values;
+		// o que as jogadas para fora da tabela (capturas, promoções) garantem:
+		// ímpar, a vitória mais curta; par, a derrota mais longa; TB_EXIT_DRAW pelo menos empate
+		std::unique_ptr<uint8_t[]> exits;
+		std::atomic<int> maxDtm;
+		std::atomic<bool> failed;
+
+		explicit TbGen(const TbLayout &l): layout{l}, values{new std::atomic<uint8_t>[l.entries]},
+		                                   exits{new uint8_t[l.entries]}, maxDtm{0}, failed{false} {}
+	};
+
+	typedef int MaterialCount[PIECE_N_COLORS][PIECE_N_TYPES];
+
+	static std::vector<std::unique_ptr<TbTable>> tables;
+	static int maxMen { 0 };
+
+	static bool parse_material(const char *s, MaterialCount &count);
+	static uint64_t material_signature(const MaterialCount &count);
+	static bool make_layout(const MaterialCount &count, TbLayout &l);
+	static uint64_t encode_oriented(const TbLayout &l, int *s, PieceColor stm);
+	static uint64_t encode(const TbLayout &l, const Square *squares, PieceColor stm);
+	static void decode(const TbLayout &l, uint64_t idx, Square *squares, PieceColor &stm);
+	static uint64_t index_of(const TbLayout &l, const Position &pos, bool flip);
+	static const TbTable *find_table(uint64_t signature);
+	static const TbTable *find_table(const Position &pos, bool &flip);
+	static bool entry_value(uint8_t b, TbWdl &wdl, int &dtm);
+	static bool load_table(const char *path);
+	static bool write_table(const TbGen &g, const char *path);
+	template<typename F>
+	static void parallel_for(ThreadPool &pool, uint64_t n, const F &f);
+	static void set_value(TbGen &g, uint64_t idx, int dtm);
+	static void gen_init(TbGen &g, uint64_t begin, uint64_t end);
+	static void gen_exits(TbGen &g, int n, uint64_t begin, uint64_t end);
+	static void gen_lost(TbGen &g, const Position &q, uint64_t qi);
+	static void gen_frontier(TbGen &g, int n, uint64_t begin, uint64_t end);
+	static bool generate(const MaterialCount &count, const char *dir, ThreadPool &pool);
+
+	// "KQKR": as peças das brancas e depois as das pretas, cada grupo a começar pelo rei
+	static bool parse_material(const char *s, MaterialCount &count){
+		memset(count, 0, sizeof(count));
+		int color = -1;
+		for(; *s; s++){
+			char c = char(toupper(*s));
+			const char *t = static_cast<const char*>(memchr(TB_LETTER, c, PIECE_N_TYPES));
+			if(!t){
+				return false;
+			}
+			if(c == 'K'){
+				if(++color > PIECE_BLACK){
+					return false;
+				}
+			} else if(color < 0){
+				return false;
+			}
+			count[color][t - TB_LETTER]++;
+		}
+		return color == PIECE_BLACK;
+	}
+
+	// 4 bits por (cor, tipo)
+	static uint64_t material_signature(const MaterialCount &count){
+		uint64_t sig = 0;
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			for(int t = 0; t < PIECE_N_TYPES; t++){
+				sig |= uint64_t(count[c][t]) << 4 * (c * PIECE_N_TYPES + t);
+			}
+		}
+		return sig;
+	}
+
+	// a cor com mais material fica com as brancas da tabela
+	static bool make_layout(const MaterialCount &count, TbLayout &l){
+		int value[PIECE_N_COLORS] = { 0, 0 }, men[PIECE_N_COLORS] = { 0, 0 };
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			for(int t = 0; t < PIECE_N_TYPES; t++){
+				value[c] += count[c][t] * PIECE_VALUE[t];
+				men[c] += count[c][t];
+			}
+		}
+		if(count[PIECE_WHITE][PIECE_KING] != 1 || count[PIECE_BLACK][PIECE_KING] != 1 ||
+		   men[0] + men[1] > TB_MAX_MEN || (count[PIECE_WHITE][PIECE_PAWN] && count[PIECE_BLACK][PIECE_PAWN])){
+			return false;
+		}
+		bool swap = value[PIECE_BLACK] > value[PIECE_WHITE] ||
+		            (value[PIECE_BLACK] == value[PIECE_WHITE] && men[PIECE_BLACK] > men[PIECE_WHITE]);
+		MaterialCount oriented;
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			memcpy(oriented[c], count[swap ? 1 - c : c], sizeof(oriented[c]));
+		}
+
+		l = TbLayout {};
+		l.piece[l.n++] = PIECE_WKING;
+		l.piece[l.n++] = PIECE_BKING;
+		int len = 0;
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			l.name[len++] = 'K';
+			for(PieceType t : TB_ORDER){
+				for(int i = 0; i < oriented[c][t]; i++){
+					l.piece[l.n++] = piece_new(t, PieceColor(c));
+					l.name[len++] = TB_LETTER[t];
+				}
+			}
+		}
+		l.pawns = oriented[PIECE_WHITE][PIECE_PAWN] || oriented[PIECE_BLACK][PIECE_PAWN];
+		l.entries = l.pawns ? TB_PAWN_KING_PAIRS : TB_KING_PAIRS;
+		for(int i = 2; i < l.n; i++){
+			l.entries *= piece_type(l.piece[i]) == PIECE_PAWN ? TB_PAWN_SQUARES : SQUARE_COUNT;
+		}
+		l.entries *= PIECE_N_COLORS;
+		l.signature = material_signature(oriented);
+		return true;
+	}
+
+	// s já na simetria escolhida; TB_NO_INDEX se a posição não tiver lugar
+	// (reis juntos, peão na primeira ou última fila)
+	static uint64_t encode_oriented(const TbLayout &l, int *s, PieceColor stm){
+		// peças iguais por ordem de casa: a mesma posição dá sempre o mesmo índice
+		for(int i = 3; i < l.n; i++){
+			for(int j = i; j > 2 && l.piece[j] == l.piece[j - 1] && s[j] < s[j - 1]; j--){
+				std::swap(s[j], s[j - 1]);
+			}
+		}
+		uint64_t idx;
+		if(l.pawns){
+			idx = uint64_t((s[0] >> 3) * 4 + (s[0] & 7)) * SQUARE_COUNT + s[1];
+		} else if(KING_PAIRS.index[s[0]][s[1]] >= 0){
+			idx = uint64_t(KING_PAIRS.index[s[0]][s[1]]);
+		} else {
+			return TB_NO_INDEX;
+		}
+		for(int i = 2; i < l.n; i++){
+			if(piece_type(l.piece[i]) != PIECE_PAWN){
+				idx = idx * SQUARE_COUNT + s[i];
+			} else if(s[i] >= A2 && s[i] <= H7){
+				idx = idx * TB_PAWN_SQUARES + (s[i] - A2);
+			} else {
+				return TB_NO_INDEX;
+			}
+		}
+		return idx * PIECE_N_COLORS + stm;
+	}
+
+	static uint64_t encode(const TbLayout &l, const Square *squares, PieceColor stm){
+		int s[TB_MAX_MEN] = {};
+		int t = l.pawns ? (square_file(squares[0]) > 3 ? 1 : 0) : KING_PAIRS.sym[squares[0]][squares[1]];
+		for(int i = 0; i < l.n; i++){
+			s[i] = sym_square(squares[i], t);
+		}
+		if(l.pawns || s[0] >> 3 != (s[0] & 7) || s[1] >> 3 != (s[1] & 7)){
+			return encode_oriented(l, s, stm);
+		}
+		// os dois reis na diagonal: a posição e a sua transposta são a mesma; fica o
+		// menor dos dois índices, senão as retrógradas só chegavam a uma delas
+		int st[TB_MAX_MEN] = {};
+		for(int i = 0; i < l.n; i++){
+			st[i] = sym_square(s[i], 4);
+		}
+		return std::min(encode_oriented(l, s, stm), encode_oriented(l, st, stm));
+	}
+
+	static void decode(const TbLayout &l, uint64_t idx, Square *squares, PieceColor &stm){
+		stm = PieceColor(idx % PIECE_N_COLORS);
+		idx /= PIECE_N_COLORS;
+		for(int i = l.n - 1; i >= 2; i--){
+			if(piece_type(l.piece[i]) == PIECE_PAWN){
+				squares[i] = Square(A2 + idx % TB_PAWN_SQUARES);
+				idx /= TB_PAWN_SQUARES;
+			} else {
+				squares[i] = Square(idx % SQUARE_COUNT);
+				idx /= SQUARE_COUNT;
+			}
+		}
+		if(l.pawns){
+			int wk = int(idx / SQUARE_COUNT);
+			squares[0] = square_new(wk % 4, wk / 4);
+			squares[1] = Square(idx % SQUARE_COUNT);
+		} else {
+			squares[0] = Square(KING_PAIRS.list[idx][0]);
+			squares[1] = Square(KING_PAIRS.list[idx][1]);
+		}
+	}
+
+	// flip: as brancas da tabela são as pretas de pos (tabuleiro virado)
+	static uint64_t index_of(const TbLayout &l, const Position &pos, bool flip){
+		Square squares[TB_MAX_MEN];
+		BitBoard used;
+		for(int i = 0; i < l.n; i++){
+			PieceColor c = piece_color(l.piece[i]);
+			BitBoard bb = pos.pieces(flip ? ~c : c, piece_type(l.piece[i])) & ~used;
+			int sq = bb.lsb();
+			used.set(sq);
+			squares[i] = Square(flip ? sq ^ 56 : sq);
+		}
+		PieceColor stm = pos.side_to_move();
+		return encode(l, squares, flip ? ~stm : stm);
+	}
+
+	static const TbTable *find_table(uint64_t signature){
+		for(const std::unique_ptr<TbTable> &t : tables){
+			if(t->layout.signature == signature){
+				return t.get();
+			}
+		}
+		return nullptr;
+	}
+
+	static const TbTable *find_table(const Position &pos, bool &flip){
+		MaterialCount count, flipped;
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			for(int t = 0; t < PIECE_N_TYPES; t++){
+				count[c][t] = flipped[1 - c][t] = pos.pieces(PieceColor(c), PieceType(t)).popcount();
+			}
+		}
+		const TbTable *t = find_table(material_signature(count));
+		flip = t == nullptr;
+		return t ? t : find_table(material_signature(flipped));
+	}
+
+	static bool entry_value(uint8_t b, TbWdl &wdl, int &dtm){
+		if(b == TB_INVALID){
+			return false;
+		}
+		dtm = b ? b - 1 : 0;
+		wdl = b == 0 ? TB_DRAW : dtm & 1 ? TB_WIN : TB_LOSS;
+		return true;
+	}
+
+	bool Position::from_pieces(const Piece *pieces, const Square *squares, int n, PieceColor stm, Position &pos){
+		pos = Position();
+		Piece bySquare[SQUARE_COUNT];
+		BitBoard occupied;
+		for(int i = 0; i < n; i++){
+			if(occupied.test(squares[i])){
+				return false;
+			}
+			occupied.set(squares[i]);
+			bySquare[squares[i]] = pieces[i];
+		}
+		Piece ordered[SQUARE_COUNT];
+		int k = 0;
+		for(int sq : occupied){
+			ordered[k++] = bySquare[sq];
+		}
+		pos.place_pieces(occupied, ordered);
+		if(pos.pieces(PIECE_WHITE, PIECE_KING).popcount() != 1 || pos.pieces(PIECE_BLACK, PIECE_KING).popcount() != 1){
+			return false;
+		}
+		pos.sideToMove = stm;
+		pos.add_state_key();
+		return (pos.attackers_to(pos.king_square(~stm), occupied) & pos.byColorBB[stm]).none();
+	}
+
+	static bool load_table(const char *path){
+		std::unique_ptr<TbTable> t(new TbTable(path));
+		if(!t->file.is_open() || t->file.size() < TB_HEADER_BYTES){
+			return false;
+		}
+		const char *data = t->file.data();
+		uint32_t magic, men;
+		uint64_t entries;
+		char name[TB_NAME_MAX + 1] = {};
+		memcpy(&magic, data, 4);
+		memcpy(&men, data + 4, 4);
+		memcpy(name, data + 8, TB_NAME_MAX);
+		memcpy(&entries, data + 16, 8);
+		MaterialCount count;
+		if(magic != TB_MAGIC || !parse_material(name, count) || !make_layout(count, t->layout) ||
+		   strcmp(name, t->layout.name) || int(men) != t->layout.n || entries != t->layout.entries ||
+		   t->file.size() != TB_HEADER_BYTES + entries || find_table(t->layout.signature)){
+			return false;
+		}
+		t->values = reinterpret_cast<const uint8_t*>(data + TB_HEADER_BYTES);
+		maxMen = std::max(maxMen, t->layout.n);
+		tables.push_back(std::move(t));
+		return true;
+	}
+
+	static bool write_table(const TbGen &g, const char *path){
+		FILE *f = fopen(path, "wb");
+		if(!f){
+			return false;
+		}
+		uint8_t header[TB_HEADER_BYTES] = {};
+		uint32_t men = uint32_t(g.layout.n);
+		memcpy(header, &TB_MAGIC, 4);
+		memcpy(header + 4, &men, 4);
+		memcpy(header + 8, g.layout.name, TB_NAME_MAX);
+		memcpy(header + 16, &g.layout.entries, 8);
+		bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+		std::vector<uint8_t> buf(1 << 16);
+		for(uint64_t i = 0; ok && i < g.layout.entries; i += buf.size()){
+			size_t n = size_t(std::min<uint64_t>(buf.size(), g.layout.entries - i));
+			for(size_t k = 0; k < n; k++){
+				buf[k] = g.values[i + k].load(std::memory_order_relaxed);
+			}
+			ok = fwrite(buf.data(), 1, n, f) == n;
+		}
+		return fclose(f) == 0 && ok;
+	}
+
+	// [0, n) em pedaços pelas threads de pool; volta quando todos acabarem
+	template<typename F>
+	static void parallel_for(ThreadPool &pool, uint64_t n, const F &f){
+		uint64_t chunks = uint64_t(std::max(pool.size(), 1)) * TB_CHUNKS_PER_THREAD;
+		uint64_t step = std::max<uint64_t>((n + chunks - 1) / chunks, 1);
+		for(uint64_t begin = 0; begin < n; begin += step){
+			uint64_t end = std::min(n, begin + step);
+			pool.submit([&f, begin, end](int){ f(begin, end); });
+		}
+		pool.wait();
+	}
+
+	// só escreve numa posição ainda por resolver
+	static void set_value(TbGen &g, uint64_t idx, int dtm){
+		if(dtm > TB_MAX_DTM){
+			g.failed = true;
+			return;
+		}
+		uint8_t expected = 0;
+		if(g.values[idx].compare_exchange_strong(expected, uint8_t(dtm + 1), std::memory_order_relaxed)){
+			int m = g.maxDtm.load(std::memory_order_relaxed);
+			while(m < dtm && !g.maxDtm.compare_exchange_weak(m, dtm, std::memory_order_relaxed)){}
+		}
+	}
+
+	// Posições impossíveis, mates, afogados e o que as saídas da tabela garantem.
+	// Uma posição cujas jogadas saem todas da tabela e perdem fica já resolvida.
+	static void gen_init(TbGen &g, uint64_t begin, uint64_t end){
+		const TbLayout &l = g.layout;
+		for(uint64_t idx = begin; idx < end; idx++){
+			Square squares[TB_MAX_MEN];
+			PieceColor stm;
+			Position pos;
+			decode(l, idx, squares, stm);
+			g.exits[idx] = 0;
+			// com peças iguais só a ordem de encode conta; as outras ficam impossíveis
+			if(!Position::from_pieces(l.piece, squares, l.n, stm, pos) || encode(l, squares, stm) != idx){
+				g.values[idx].store(TB_INVALID, std::memory_order_relaxed);
+				continue;
+			}
+			g.values[idx].store(0, std::memory_order_relaxed);
+
+			MoveList list;
+			pos.generate_legal(list);
+			if(list.size() == 0){
+				if(pos.in_check()){
+					set_value(g, idx, 0);
+				} else {
+					g.exits[idx] = TB_EXIT_DRAW;
+				}
+				continue;
+			}
+			int win = 0, loss = 0, inside = 0;
+			bool draw = false;
+			for(Move m : list){
+				if(!pos.is_capture(m) && move_type(m) != MOVE_PROMOTION){
+					inside++;
+					continue;
+				}
+				Position child = pos;
+				StateInfo st;
+				TbWdl wdl;
+				int dtm;
+				child.do_move(m, st);
+				if(!tb_probe(child, wdl, dtm)){
+					g.failed = true;
+					continue;
+				}
+				if(wdl == TB_LOSS){
+					win = win ? std::min(win, dtm + 1) : dtm + 1;
+				} else if(wdl == TB_DRAW){
+					draw = true;
+				} else {
+					loss = std::max(loss, dtm + 1);
+				}
+			}
+			if(std::max(win, loss) > TB_MAX_DTM){
+				g.failed = true;
+				continue;
+			}
+			g.exits[idx] = uint8_t(win ? win : draw ? TB_EXIT_DRAW : loss);
+			if(win){
+				int m = g.maxDtm.load(std::memory_order_relaxed);
+				while(m < win && !g.maxDtm.compare_exchange_weak(m, win, std::memory_order_relaxed)){}
+			} else if(!draw && inside == 0){
+				set_value(g, idx, loss);
+			}
+		}
+	}
+
+	// vitórias em n meias-jogadas que só se conseguem saindo da tabela
+	static void gen_exits(TbGen &g, int n, uint64_t begin, uint64_t end){
+		for(uint64_t idx = begin; idx < end; idx++){
+			if(g.exits[idx] == n && g.values[idx].load(std::memory_order_relaxed) == 0){
+				set_value(g, idx, n);
+			}
+		}
+	}
+
+	// q perde se todas as jogadas dentro da tabela derem vitória ao adversário
+	// (as de fora já se sabe que perdem); a distância é a da defesa mais longa
+	static void gen_lost(TbGen &g, const Position &q, uint64_t qi){
+		MoveList list;
+		q.generate_legal(list);
+		int worst = g.exits[qi];
+		for(Move m : list){
+			if(q.is_capture(m) || move_type(m) == MOVE_PROMOTION){
+				continue;
+			}
+			Position child = q;
+			StateInfo st;
+			child.do_move(m, st);
+			uint8_t b = g.values[index_of(g.layout, child, false)].load(std::memory_order_relaxed);
+			if(b == 0 || b == TB_INVALID || (b - 1) % 2 == 0){
+				return;
+			}
+			worst = std::max(worst, int(b));
+		}
+		set_value(g, qi, worst);
+	}
+
+	// Retrógrada a partir das posições com DTM n: desfazem-se as jogadas de quem
+	// acabou de jogar (sem capturas nem promoções, que vêm de outras tabelas).
+	// Depois de uma derrota, quem lá chega ganha em n + 1; depois de uma vitória,
+	// verifica-se se o antecessor ficou sem fuga.
+	static void gen_frontier(TbGen &g, int n, uint64_t begin, uint64_t end){
+		const TbLayout &l = g.layout;
+		for(uint64_t idx = begin; idx < end; idx++){
+			if(g.values[idx].load(std::memory_order_relaxed) != n + 1){
+				continue;
+			}
+			Square squares[TB_MAX_MEN];
+			PieceColor stm;
+			decode(l, idx, squares, stm);
+			PieceColor mover = ~stm;
+			BitBoard occupied;
+			for(int i = 0; i < l.n; i++){
+				occupied.set(squares[i]);
+			}
+			for(int i = 0; i < l.n; i++){
+				if(piece_color(l.piece[i]) != mover){
+					continue;
+				}
+				Square sq = squares[i];
+				PieceType t = piece_type(l.piece[i]);
+				BitBoard origins;
+				if(t != PIECE_PAWN){
+					origins = piece_attacks(t, sq, occupied) & ~occupied;
+				} else {
+					int back = mover == PIECE_WHITE ? -8 : 8;
+					int rank = mover == PIECE_WHITE ? square_rank(sq) : 7 - square_rank(sq);
+					if(rank >= 2 && !occupied.test(sq + back)){
+						origins.set(sq + back);
+						if(rank == 3 && !occupied.test(sq + 2 * back)){
+							origins.set(sq + 2 * back);
+						}
+					}
+				}
+				for(int from : origins){
+					Square before[TB_MAX_MEN];
+					Position q;
+					std::copy(squares, squares + l.n, before);
+					before[i] = Square(from);
+					if(!Position::from_pieces(l.piece, before, l.n, mover, q)){
+						continue;
+					}
+					uint64_t qi = encode(l, before, mover);
+					if(n % 2 == 0){
+						set_value(g, qi, n + 1);
+						continue;
+					}
+					uint8_t e = g.exits[qi];
+					if(g.values[qi].load(std::memory_order_relaxed) == 0 && e % 2 == 0 && e != TB_EXIT_DRAW){
+						gen_lost(g, q, qi);
+					}
+				}
+			}
+		}
+	}
+
+	static bool generate(const MaterialCount &count, const char *dir, ThreadPool &pool){
+		TbLayout l;
+		if(!make_layout(count, l)){
+			return false;
+		}
+		if(l.n == 2 || find_table(l.signature)){
+			return true;
+		}
+		// primeiro as tabelas para onde se sai com capturas e promoções
+		for(int c = 0; c < PIECE_N_COLORS; c++){
+			for(int t = 0; t < PIECE_KING; t++){
+				if(!count[c][t]){
+					continue;
+				}
+				MaterialCount sub;
+				memcpy(sub, count, sizeof(sub));
+				sub[c][t]--;
+				if(!generate(sub, dir, pool)){
+					return false;
+				}
+				for(int p = PIECE_KNIGHT; t == PIECE_PAWN && p <= PIECE_QUEEN; p++){
+					sub[c][p]++;
+					bool ok = generate(sub, dir, pool);
+					sub[c][p]--;
+					if(!ok){
+						return false;
+					}
+				}
+			}
+		}
+
+		TbGen g { l };
+		parallel_for(pool, l.entries, [&g](uint64_t b, uint64_t e){ gen_init(g, b, e); });
+		for(int n = 0; n <= g.maxDtm.load() && !g.failed; n++){
+			if(n % 2 == 1){
+				parallel_for(pool, l.entries, [&g, n](uint64_t b, uint64_t e){ gen_exits(g, n, b, e); });
+			}
+			parallel_for(pool, l.entries, [&g, n](uint64_t b, uint64_t e){ gen_frontier(g, n, b, e); });
+		}
+		if(g.failed){
+			return false;
+		}
+		std::string path = std::string(dir) + "/" + l.name + ".xtb";
+		return write_table(g, path.c_str()) && load_table(path.c_str());
+	}
+
+	bool tb_generate(const char *material, const char *dir, ThreadPool &pool){
+		MaterialCount count;
+		return parse_material(material, count) && generate(count, dir, pool);
+	}
+
+	int tb_load(const char *dir){
+		DIR *d = opendir(dir);
+		if(!d){
+			return 0;
+		}
+		int n = 0;
+		while(dirent *e = readdir(d)){
+			size_t len = strlen(e->d_name);
+			if(len > 4 && !strcmp(e->d_name + len - 4, ".xtb")){
+				n += load_table((std::string(dir) + "/" + e->d_name).c_str());
+			}
+		}
+		closedir(d);
+		return n;
+	}
+
+	void tb_clear(void){
+		tables.clear();
+		maxMen = 0;
+	}
+
+	int tb_max_men(void){
+		return maxMen;
+	}
+
+	bool tb_stats(const char *material, TbStats &stats){
+		MaterialCount count;
+		TbLayout l;
+		if(!parse_material(material, count) || !make_layout(count, l)){
+			return false;
+		}
+		const TbTable *t = find_table(l.signature);
+		if(!t){
+			return false;
+		}
+		stats = TbStats {};
+		stats.entries = l.entries;
+		for(uint64_t idx = 0; idx < l.entries; idx++){
+			TbWdl wdl;
+			int dtm;
+			PieceColor stm = PieceColor(idx % PIECE_N_COLORS);
+			if(!entry_value(t->values[idx], wdl, dtm)){
+				continue;
+			}
+			if(wdl == TB_WIN){
+				stats.wins[stm]++;
+				stats.longest[stm] = std::max(stats.longest[stm], dtm);
+			} else if(wdl == TB_LOSS){
+				stats.losses[stm]++;
+			} else {
+				stats.draws[stm]++;
+			}
+		}
+		return true;
+	}
+
+	bool tb_probe(const Position &pos, TbWdl &wdl, int &dtm){
+		if(pos.castle_rights() != CASTLE_NONE || pos.ep_square() != SQUARE_NONE){
+			return false;
+		}
+		int men = pos.pieces().popcount();
+		if(men == 2){
+			wdl = TB_DRAW;
+			dtm = 0;
+			return true;
+		}
+		bool flip;
+		const TbTable *t = men <= maxMen ? find_table(pos, flip) : nullptr;
+		if(!t){
+			return false;
+		}
+		uint64_t idx = index_of(t->layout, pos, flip);
+		return idx != TB_NO_INDEX && entry_value(t->values[idx], wdl, dtm);
+	}
+
+	Move tb_best_move(const Position &pos, TbWdl &wdl, int &dtm){
+		if(!tb_probe(pos, wdl, dtm)){
+			return NO_MOVE;
+		}
+		MoveList list;
+		pos.generate_legal(list);
+		Move best = NO_MOVE;
+		int bestScore = 0;
+		for(Move m : list){
+			Position child = pos;
+			StateInfo st;
+			TbWdl w;
+			int d;
+			child.do_move(m, st);
+			if(!tb_probe(child, w, d)){
+				return NO_MOVE;
+			}
+			// o adversário a perder depressa, depois empate, depois perder devagar
+			int score = w == TB_LOSS ? 2 * TB_MAX_DTM - d : w == TB_DRAW ? 0 : -2 * TB_MAX_DTM + d;
+			if(best == NO_MOVE || score > bestScore){
+				best = m;
+				bestScore = score;
+			}
+		}
+		return best;
+	}
+}
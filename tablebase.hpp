@@ -0,0 +1,70 @@
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include <cstdint>
+#include "chess.hpp"
+#include "threadpool.hpp"
+
+namespace chess {
+
+	// Tabelas de finais com distância até ao mate (DTM), geradas aqui por análise
+	// retrógrada e lidas por mmap: a pesquisa resolve estas posições sem nós.
+	//
+	// Material: as peças das brancas e depois as das pretas, cada grupo a começar pelo
+	// rei ("KQK", "KBNK", "KRPKR"). Cada tabela serve também para as cores trocadas.
+	// Até TB_MAX_MEN peças; peões só de um dos lados (assim nunca há en passant).
+	// As posições com roque ou en passant não se consultam, e a regra dos 50 lances
+	// não conta.
+	//
+	// Índice: par de reis reduzido pela simetria (462 pares sem peões, com o rei branco
+	// no triângulo a1-d1-d4; com peões só o espelho a-h, rei branco nas colunas a-d),
+	// depois 64 casas por peça (48 por peão) e a vez. Um byte por posição:
+	//      0 empate, TB_INVALID posição impossível, senão 1 + DTM em meias-jogadas
+	//      (ímpar: quem joga dá mate; par: leva mate)
+	//
+	// Ficheiro <dir>/<material>.xtb (little-endian):
+	//      uint32 TB_MAGIC, uint32 peças, char material[8], uint64 posições
+	//      uint8  valores[posições]
+
+	constexpr uint32_t TB_MAGIC { 0x31425458 }; // "XTB1"
+	constexpr int TB_MAX_MEN { 5 };
+	constexpr uint8_t TB_INVALID { 255 };
+	constexpr int TB_MAX_DTM { 253 };
+
+	enum TbWdl : int {
+		TB_LOSS = -1,
+		TB_DRAW = 0,
+		TB_WIN = 1,
+	};
+
+	// contagem das posições possíveis de uma tabela, por quem joga (cores da tabela)
+	struct TbStats {
+		uint64_t wins[PIECE_N_COLORS];
+		uint64_t draws[PIECE_N_COLORS];
+		uint64_t losses[PIECE_N_COLORS];
+		int longest[PIECE_N_COLORS]; // maior DTM de uma vitória
+		uint64_t entries; // incluindo as impossíveis e as repetidas pela ordem de peças iguais
+	};
+
+	// Gera a tabela e, antes dela, as que faltarem para as capturas e promoções
+	// (KQKR precisa de KQK e KRK; KPK de KQK, KRK, KBK e KNK), em dir, e deixa-as
+	// carregadas. Cada meia-jogada de distância é uma passagem pela tabela dividida
+	// pelas threads de pool. false se o material não servir ou a escrita falhar.
+	bool tb_generate(const char *material, const char *dir, ThreadPool &pool);
+	// junta as tabelas de dir às já carregadas (ficheiros .xtb); devolve quantas juntou
+	int tb_load(const char *dir);
+	void tb_clear(void);
+	// mais peças de uma tabela carregada; 0 se não houver nenhuma
+	int tb_max_men(void);
+	// false se a tabela do material não estiver carregada
+	bool tb_stats(const char *material, TbStats &stats);
+
+	// do ponto de vista de quem joga; dtm em meias-jogadas (0 com empate ou mate já
+	// dado). false se não houver tabela para a posição
+	bool tb_probe(const Position &pos, TbWdl &wdl, int &dtm);
+	// a jogada que mantém o resultado pelo caminho mais curto (ou, a perder, o mais
+	// longo); NO_MOVE se a posição não estiver nas tabelas ou não houver jogadas
+	Move tb_best_move(const Position &pos, TbWdl &wdl, int &dtm);
+}
+
+#endif // TABLEBASE_HPP
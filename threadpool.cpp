@@ -0,0 +1,92 @@
+#include "threadpool.hpp"
+
+namespace chess {
+
+	ThreadPool::ThreadPool(int n): queued{0}, unfinished{0}, nextQueue{0}, stopping{false} {
+		if(n < 1){
+			n = 1;
+		}
+		for(int i = 0; i < n; i++){
+			this->queues.emplace_back(new Queue);
+		}
+		for(int i = 0; i < n; i++){
+			this->threads.emplace_back(&ThreadPool::worker_main, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool(void){
+		{
+			std::lock_guard<std::mutex> l(this->sleepLock);
+			this->stopping = true;
+		}
+		this->wakeUp.notify_all();
+		for(std::thread &t : this->threads){
+			t.join();
+		}
+	}
+
+	void ThreadPool::submit(Task t){
+		Queue &q = *this->queues[this->nextQueue++ % this->queues.size()];
+		this->unfinished++;
+		{
+			std::lock_guard<std::mutex> l(q.lock);
+			q.tasks.push_back(std::move(t));
+		}
+		{
+			std::lock_guard<std::mutex> l(this->sleepLock);
+			this->queued++;
+		}
+		this->wakeUp.notify_one();
+	}
+
+	void ThreadPool::wait(void){
+		std::unique_lock<std::mutex> l(this->sleepLock);
+		this->allDone.wait(l, [this]{ return this->unfinished == 0; });
+	}
+
+	bool ThreadPool::pop(int worker, Task &t){
+		Queue &q = *this->queues[worker];
+		std::lock_guard<std::mutex> l(q.lock);
+		if(q.tasks.empty()){
+			return false;
+		}
+		t = std::move(q.tasks.back());
+		q.tasks.pop_back();
+		return true;
+	}
+
+	bool ThreadPool::steal(int worker, Task &t){
+		int n = int(this->queues.size());
+		for(int i = 1; i < n; i++){
+			Queue &q = *this->queues[(worker + i) % n];
+			std::lock_guard<std::mutex> l(q.lock);
+			if(!q.tasks.empty()){
+				t = std::move(q.tasks.front());
+				q.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ThreadPool::worker_main(int worker){
+		for(;;){
+			Task t;
+			if(this->pop(worker, t) || this->steal(worker, t)){
+				this->queued--;
+				t(worker);
+				if(--this->unfinished == 0){
+					std::lock_guard<std::mutex> l(this->sleepLock);
+					this->allDone.notify_all();
+				}
+				continue;
+			}
+
+			std::unique_lock<std::mutex> l(this->sleepLock);
+			this->wakeUp.wait(l, [this]{ return this->stopping || this->queued > 0; });
+			if(this->stopping && this->queued == 0){
+				return;
+			}
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chess {
+
+	// Conjunto de threads com roubo de trabalho: cada thread tem a sua fila,
+	// tira do fim da sua e, quando fica sem nada, rouba do início das outras.
+	class ThreadPool {
+		public:
+		// recebe o índice da thread que a executa (0..size()-1)
+		typedef std::function<void(int)> Task;
+
+		private:
+		struct Queue {
+			std::mutex lock;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> threads;
+		std::atomic<int> queued;   // tarefas nas filas
+		std::atomic<int> unfinished; // tarefas submetidas e ainda não acabadas
+		std::atomic<unsigned> nextQueue;
+		bool stopping;
+		std::mutex sleepLock;
+		std::condition_variable wakeUp;
+		std::condition_variable allDone;
+
+		bool pop(int worker, Task &t);
+		bool steal(int worker, Task &t);
+		void worker_main(int worker);
+
+		public:
+		explicit ThreadPool(int n);
+		~ThreadPool(void);
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+
+		// distribui pelas filas de forma circular
+		void submit(Task t);
+		// bloqueia até todas as tarefas submetidas terem acabado
+		void wait(void);
+		int size(void) const { return int(this->threads.size()); }
+	};
+}
+
+#endif // THREADPOOL_HPP
@@ -0,0 +1,159 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "tt.hpp"
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace chess {
+
+	static uint64_t pack_data(uint64_t key, Move m, int score, int depth, Bound b, uint8_t gen);
+	static bool data_matches(uint64_t d, uint64_t key);
+	static Move data_move(uint64_t d);
+	static Bound data_bound(uint64_t d);
+	static int data_depth(uint64_t d);
+	static uint8_t data_generation(uint64_t d);
+	static uint64_t load(const uint64_t *p);
+	static void save(uint64_t *p, uint64_t v);
+
+	static uint64_t pack_data(uint64_t key, Move m, int score, int depth, Bound b, uint8_t gen){
+		return (key & 0xFFFF) |
+		       (uint64_t(m) << 16) |
+		       (uint64_t(uint16_t(int16_t(score))) << 32) |
+		       (uint64_t(uint8_t(int8_t(depth))) << 48) |
+		       (uint64_t(b) << 56) |
+		       (uint64_t(gen) << 58);
+	}
+	static bool data_matches(uint64_t d, uint64_t key){
+		return ((d ^ key) & 0xFFFF) == 0;
+	}
+	static Move data_move(uint64_t d){
+		return Move(d >> 16);
+	}
+	static Bound data_bound(uint64_t d){
+		return Bound((d >> 56) & 3);
+	}
+	static int data_depth(uint64_t d){
+		return int8_t(d >> 48);
+	}
+	static uint8_t data_generation(uint64_t d){
+		return uint8_t(d >> 58);
+	}
+
+	// acessos atómicos "relaxed": em x86 são movs simples, mas sem corridas indefinidas
+	static uint64_t load(const uint64_t *p){
+		return __atomic_load_n(p, __ATOMIC_RELAXED);
+	}
+	static void save(uint64_t *p, uint64_t v){
+		__atomic_store_n(p, v, __ATOMIC_RELAXED);
+	}
+
+	TranspositionTable::~TranspositionTable(void){
+		std::free(this->buckets);
+	}
+
+	void TranspositionTable::resize(size_t mb){
+		std::free(this->buckets);
+		this->buckets = nullptr;
+
+		// páginas grandes (2 MB) reduzem as falhas de TLB numa tabela acedida ao acaso
+		size_t bytes = mb * 1024 * 1024;
+		#ifdef __linux__
+		size_t align = 2 * 1024 * 1024;
+		#else
+		size_t align = alignof(TTBucket);
+		#endif
+		bytes = (bytes + align - 1) / align * align;
+		if(bytes < align){
+			bytes = align;
+		}
+
+		this->buckets = static_cast<TTBucket*>(std::aligned_alloc(align, bytes));
+		if(!this->buckets){
+			throw std::bad_alloc();
+		}
+		#ifdef __linux__
+		madvise(this->buckets, bytes, MADV_HUGEPAGE);
+		#endif
+
+		this->bucketCount = bytes / sizeof(TTBucket);
+		this->sizeMB = mb;
+		this->clear();
+	}
+
+	void TranspositionTable::clear(void){
+		std::memset(static_cast<void*>(this->buckets), 0, this->bucketCount * sizeof(TTBucket));
+		this->generation = 0;
+	}
+
+	bool TranspositionTable::probe(uint64_t key, TTData &out, TTStats *stats) const {
+		const TTBucket *b = this->bucket(key);
+		if(stats){
+			stats->probes++;
+		}
+		for(const TTEntry &e : b->entries){
+			uint64_t d = load(&e.data);
+			if(!data_matches(d, key) || data_bound(d) == BOUND_NONE){
+				continue;
+			}
+			out.move = data_move(d);
+			out.score = int16_t(d >> 32);
+			out.depth = data_depth(d);
+			out.bound = data_bound(d);
+			if(stats){
+				stats->hits++;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void TranspositionTable::store(uint64_t key, Move m, int score, int depth, Bound bound, TTStats *stats){
+		TTBucket *b = this->bucket(key);
+		TTEntry *replace = &b->entries[0];
+		int worst = 1 << 30;
+
+		for(TTEntry &e : b->entries){
+			uint64_t d = load(&e.data);
+			if(data_matches(d, key) && data_bound(d) != BOUND_NONE){
+				// mesma posição: não perder a jogada nem uma pesquisa bem mais funda
+				if(move_type(m) == MOVE_NONE){
+					m = data_move(d);
+				}
+				if(bound != BOUND_EXACT && depth + 3 < data_depth(d) &&
+				   data_generation(d) == this->generation){
+					return;
+				}
+				replace = &e;
+				break;
+			}
+			// substitui a entrada mais rasa, contando cada geração de idade como 8 de profundidade
+			int age = (this->generation - data_generation(d)) & 63;
+			int value = data_bound(d) == BOUND_NONE ? -(1 << 30) : data_depth(d) - 8*age;
+			if(value < worst){
+				worst = value;
+				replace = &e;
+			}
+		}
+
+		save(&replace->data, pack_data(key, m, score, depth, bound, this->generation));
+		if(stats){
+			stats->stores++;
+		}
+	}
+
+	int TranspositionTable::hashfull(void) const {
+		size_t n = this->bucketCount < 250 ? this->bucketCount : 250;
+		int used = 0;
+		for(size_t i = 0; i < n; i++){
+			for(const TTEntry &e : this->buckets[i].entries){
+				uint64_t d = load(&e.data);
+				if(data_bound(d) != BOUND_NONE && data_generation(d) == this->generation){
+					used++;
+				}
+			}
+		}
+		return n ? int(used * 1000 / (n * TT_BUCKET_SIZE)) : 0;
+	}
+}
@@ -0,0 +1,89 @@
+#ifndef TT_HPP
+#define TT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "chess.hpp"
+
+namespace chess {
+
+	enum Bound : int {
+		BOUND_NONE,
+		BOUND_UPPER,
+		BOUND_LOWER,
+		BOUND_EXACT = BOUND_UPPER | BOUND_LOWER,
+	};
+
+	struct TTData {
+		Move move;
+		int score;
+		int depth;
+		Bound bound;
+	};
+
+	// Contadores de cada thread; a tabela não os partilha para não haver disputa de linhas de cache.
+	struct TTStats {
+		uint64_t probes;
+		uint64_t hits;
+		uint64_t stores;
+
+		TTStats(void): probes{0}, hits{0}, stores{0} {}
+		double hit_rate(void) const {
+			return this->probes ? double(this->hits) / double(this->probes) : 0.0;
+		}
+		TTStats &operator+=(const TTStats &o){
+			this->probes += o.probes;
+			this->hits += o.hits;
+			this->stores += o.stores;
+			return *this;
+		}
+	};
+
+	// ENTRADA: 8 bytes
+	// bits 0-15 verificação (16 bits baixos da chave; os altos já escolheram o balde),
+	// 16-31 jogada, 32-47 valor, 48-55 profundidade, 56-57 limite, 58-63 geração
+	// Lida e escrita de uma só vez, uma escrita concorrente nunca deixa a entrada a meio.
+	struct TTEntry {
+		uint64_t data;
+	};
+
+	constexpr int TT_BUCKET_SIZE { 8 };
+
+	struct alignas(64) TTBucket {
+		TTEntry entries[TT_BUCKET_SIZE];
+	};
+
+	class TranspositionTable {
+		TTBucket *buckets;
+		size_t bucketCount;
+		size_t sizeMB;
+		uint8_t generation;
+
+		TTBucket *bucket(uint64_t key) const {
+			return this->buckets + mul_hi64(key, this->bucketCount);
+		}
+
+		public:
+		TranspositionTable(void): buckets{nullptr}, bucketCount{0}, sizeMB{0}, generation{0} {}
+		~TranspositionTable(void);
+		TranspositionTable(const TranspositionTable &) = delete;
+		TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+		// não é seguro com pesquisas a decorrer
+		void resize(size_t mb);
+		void clear(void);
+		void new_search(void){ this->generation = (this->generation + 1) & 63; }
+
+		void prefetch(uint64_t key) const {
+			__builtin_prefetch(this->bucket(key));
+		}
+		bool probe(uint64_t key, TTData &out, TTStats *stats = nullptr) const;
+		void store(uint64_t key, Move m, int score, int depth, Bound b, TTStats *stats = nullptr);
+
+		// permilagem de entradas ocupadas na pesquisa atual (amostra dos primeiros baldes)
+		int hashfull(void) const;
+		size_t size_mb(void) const { return this->sizeMB; }
+	};
+}
+
+#endif // TT_HPP
@@ -0,0 +1,380 @@
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "book.hpp"
+#include "chess.hpp"
+#include "search.hpp"
+#include "tablebase.hpp"
+#include "tt.hpp"
+
+// Motor sem SDL que fala UCI pelo stdin/stdout, para correr em servidores e
+// ser usado por interfaces e gestores de torneios.
+//
+// A pesquisa corre numa thread à parte e a principal continua a ler comandos,
+// por isso stop, isready e ponderhit têm resposta imediata durante a pesquisa.
+//
+// Opções: Hash (MB), Threads, MultiPV e Ponder (só anunciada: quem pede para
+// pensar no tempo do adversário é a interface, com "go ponder").
+// OwnBook e BookFile: livro Polyglot (ver book.hpp). Com OwnBook, um "go" numa
+// posição do livro responde logo com uma jogada dele, sem pesquisar.
+// TablebasePath: pasta com tabelas de finais .xtb (ver tablebase.hpp; geram-se com
+// bench -tb). Com a raiz nas tabelas, "go" responde logo com a jogada delas.
+//
+//      DEBUGFLAGS="-O3 -DNDEBUG" ./compile.sh uci
+
+using chess::Move;
+using chess::Position;
+using chess::Search;
+using chess::SearchLimits;
+using chess::SearchReport;
+using chess::TranspositionTable;
+
+constexpr size_t HASH_DEFAULT { 16 };
+constexpr size_t HASH_MAX { 65536 };
+constexpr int THREADS_MAX { 256 };
+
+class Engine {
+	TranspositionTable tt;
+	Search search;
+	Position root;
+	// chaves das posições antes da raiz desde a última jogada irreversível
+	std::vector<uint64_t> history;
+	int multiPV;
+	std::unique_ptr<chess::Book> book;
+	bool ownBook;
+
+	std::thread searcher;
+	// a pesquisa e a thread principal escrevem as duas no stdout
+	std::mutex outMutex;
+	// primeira e segunda jogadas da última linha principal reportada; só a thread de
+	// pesquisa lhes mexe
+	Move ponderBest;
+	Move ponderMove;
+
+	void send(const char *fmt, ...);
+	void report(const SearchReport &r);
+	void wait(void);
+
+	void cmd_uci(void);
+	void cmd_setoption(std::istringstream &is);
+	void cmd_position(std::istringstream &is);
+	void cmd_go(std::istringstream &is);
+
+	public:
+	Engine(void);
+	~Engine(void);
+
+	// devolve false com "quit"
+	bool execute(const std::string &line);
+};
+
+static Move parse_move(const Position &pos, const std::string &s);
+static void format_score(int v, char (&buf)[32]);
+
+// jogada em notação de coordenadas, procurada entre as legais; NO_MOVE se não for nenhuma
+static Move parse_move(const Position &pos, const std::string &s){
+	chess::MoveList list;
+	pos.generate_legal(list);
+	char name[6];
+	for(Move m : list){
+		chess::move_name(m, name);
+		if(s == name){
+			return m;
+		}
+	}
+	return chess::NO_MOVE;
+}
+
+// "cp 31" ou "mate 3" (negativo quando é quem joga que leva mate)
+static void format_score(int v, char (&buf)[32]){
+	if(v >= chess::VALUE_MATE_IN_MAX_PLY){
+		snprintf(buf, sizeof(buf), "mate %d", (chess::VALUE_MATE - v + 1) / 2);
+	} else if(v <= -chess::VALUE_MATE_IN_MAX_PLY){
+		snprintf(buf, sizeof(buf), "mate %d", -(chess::VALUE_MATE + v) / 2);
+	} else {
+		snprintf(buf, sizeof(buf), "cp %d", v);
+	}
+}
+
+Engine::Engine(void): search{tt}, multiPV{1}, ownBook{false}, ponderBest{chess::NO_MOVE},
+                      ponderMove{chess::NO_MOVE} {
+	this->tt.resize(HASH_DEFAULT);
+	Position::from_fen(chess::START_FEN, this->root);
+	this->search.set_reporter([this](const SearchReport &r){ this->report(r); });
+}
+
+Engine::~Engine(void){
+	this->search.stop();
+	this->wait();
+}
+
+void Engine::send(const char *fmt, ...){
+	std::lock_guard<std::mutex> lock(this->outMutex);
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	putchar('\n');
+	fflush(stdout);
+}
+
+void Engine::report(const SearchReport &r){
+	char score[32];
+	format_score(r.score, score);
+	// sem std::string: isto corre dentro da pesquisa, que não pode pedir memória
+	char pv[(chess::MAX_PLY + 1) * 6 + 1];
+	char name[6];
+	size_t len = 0;
+	for(int i = 0; i < r.pvLength; i++){
+		chess::move_name(r.pv[i], name);
+		len += snprintf(pv + len, sizeof(pv) - len, " %s", name);
+	}
+	pv[len] = '\0';
+	if(r.multipv == 1){
+		this->ponderBest = r.pvLength > 0 ? r.pv[0] : chess::NO_MOVE;
+		this->ponderMove = r.pvLength > 1 ? r.pv[1] : chess::NO_MOVE;
+	}
+	this->send("info depth %d seldepth %d multipv %d score %s nodes %llu nps %llu hashfull %d time %lld pv%s",
+	           r.depth, r.seldepth, r.multipv, score, (unsigned long long)r.nodes, (unsigned long long)r.nps,
+	           r.hashfull, (long long)r.timeMs, pv);
+}
+
+// as opções e a posição só se mexem com a pesquisa parada
+void Engine::wait(void){
+	if(this->searcher.joinable()){
+		this->searcher.join();
+	}
+}
+
+void Engine::cmd_uci(void){
+	this->send("id name Xadrez");
+	this->send("id author JGSVb");
+	this->send("option name Hash type spin default %zu min 1 max %zu", HASH_DEFAULT, HASH_MAX);
+	this->send("option name Threads type spin default 1 min 1 max %d", THREADS_MAX);
+	this->send("option name MultiPV type spin default 1 min 1 max %d", chess::MAX_MULTIPV);
+	this->send("option name Ponder type check default false");
+	this->send("option name OwnBook type check default false");
+	this->send("option name BookFile type string default <empty>");
+	this->send("option name TablebasePath type string default <empty>");
+	this->send("uciok");
+}
+
+// setoption name <nome> [value <valor>]; o nome pode ter espaços
+void Engine::cmd_setoption(std::istringstream &is){
+	std::string token, name, value;
+	is >> token; // "name"
+	while(is >> token && token != "value"){
+		name += name.empty() ? token : " " + token;
+	}
+	while(is >> token){
+		value += value.empty() ? token : " " + token;
+	}
+
+	this->wait();
+	if(!strcasecmp(name.c_str(), "Hash")){
+		size_t mb = strtoull(value.c_str(), nullptr, 10);
+		this->tt.resize(mb < 1 ? 1 : mb > HASH_MAX ? HASH_MAX : mb);
+	} else if(!strcasecmp(name.c_str(), "Threads")){
+		int n = atoi(value.c_str());
+		this->search.set_threads(n < 1 ? 1 : n > THREADS_MAX ? THREADS_MAX : n);
+	} else if(!strcasecmp(name.c_str(), "MultiPV")){
+		int n = atoi(value.c_str());
+		this->multiPV = n < 1 ? 1 : n > chess::MAX_MULTIPV ? chess::MAX_MULTIPV : n;
+	} else if(!strcasecmp(name.c_str(), "OwnBook")){
+		this->ownBook = value == "true";
+	} else if(!strcasecmp(name.c_str(), "BookFile")){
+		// só se mapeia: abrir um livro grande não custa nada
+		this->book.reset();
+		if(value.empty() || value == "<empty>"){
+			return;
+		}
+		this->book.reset(new chess::Book(value.c_str(), std::random_device{}()));
+		if(!this->book->is_open()){
+			this->send("info string livro inválido: %s", value.c_str());
+			this->book.reset();
+		}
+	} else if(!strcasecmp(name.c_str(), "TablebasePath")){
+		chess::tb_clear();
+		if(!value.empty() && value != "<empty>"){
+			this->send("info string %d tabelas de finais em %s", chess::tb_load(value.c_str()), value.c_str());
+		}
+	} else if(strcasecmp(name.c_str(), "Ponder")){
+		this->send("info string opção desconhecida: %s", name.c_str());
+	}
+}
+
+// position startpos|fen <fen> [moves <jogadas>...]
+void Engine::cmd_position(std::istringstream &is){
+	std::string token, fen;
+	is >> token;
+	if(token == "startpos"){
+		fen = chess::START_FEN;
+		is >> token; // "moves", se houver
+	} else if(token == "fen"){
+		while(is >> token && token != "moves"){
+			fen += fen.empty() ? token : " " + token;
+		}
+	} else {
+		return;
+	}
+
+	this->wait();
+	Position pos;
+	if(!Position::from_fen(fen.c_str(), pos)){
+		this->send("info string FEN inválida: %s", fen.c_str());
+		return;
+	}
+	this->history.clear();
+	while(is >> token){
+		Move m = parse_move(pos, token);
+		if(m == chess::NO_MOVE){
+			this->send("info string jogada ilegal: %s", token.c_str());
+			break;
+		}
+		// nada antes de uma captura ou jogada de peão se pode repetir
+		bool irreversible = pos.is_capture(m) || chess::piece_type(pos.get_piece(chess::move_src(m))) == chess::PIECE_PAWN;
+		if(irreversible){
+			this->history.clear();
+		} else {
+			this->history.push_back(pos.get_key());
+		}
+		chess::StateInfo st;
+		pos.do_move(m, st);
+	}
+	this->root = pos;
+}
+
+void Engine::cmd_go(std::istringstream &is){
+	SearchLimits lim;
+	lim.multiPV = this->multiPV;
+	std::string token;
+	while(is >> token){
+		if(token == "wtime"){
+			is >> lim.time[chess::PIECE_WHITE];
+		} else if(token == "btime"){
+			is >> lim.time[chess::PIECE_BLACK];
+		} else if(token == "winc"){
+			is >> lim.inc[chess::PIECE_WHITE];
+		} else if(token == "binc"){
+			is >> lim.inc[chess::PIECE_BLACK];
+		} else if(token == "movestogo"){
+			is >> lim.movestogo;
+		} else if(token == "depth"){
+			is >> lim.depth;
+		} else if(token == "nodes"){
+			is >> lim.nodes;
+		} else if(token == "movetime"){
+			is >> lim.movetime;
+		} else if(token == "infinite"){
+			lim.infinite = true;
+		} else if(token == "ponder"){
+			lim.ponder = true;
+		}
+	}
+
+	this->wait();
+	// a pensar no tempo do adversário ou sem fim, quem manda parar é a interface
+	if(this->ownBook && this->book && !lim.infinite && !lim.ponder){
+		Move m = this->book->probe(this->root);
+		if(m != chess::NO_MOVE){
+			char name[6];
+			chess::move_name(m, name);
+			this->send("bestmove %s", name);
+			return;
+		}
+	}
+	// final nas tabelas: a jogada sai delas, sem nenhum nó de pesquisa
+	chess::TbWdl wdl;
+	int dtm;
+	Move tbMove = lim.infinite || lim.ponder ? chess::NO_MOVE : chess::tb_best_move(this->root, wdl, dtm);
+	if(tbMove != chess::NO_MOVE){
+		char name[6];
+		chess::move_name(tbMove, name);
+		if(wdl == chess::TB_DRAW){
+			this->send("info depth 1 score cp 0 nodes 0 pv %s", name);
+		} else {
+			this->send("info depth 1 score mate %d nodes 0 pv %s", wdl == chess::TB_WIN ? (dtm + 1) / 2 : -dtm / 2, name);
+		}
+		this->send("bestmove %s", name);
+		return;
+	}
+	this->ponderBest = chess::NO_MOVE;
+	this->ponderMove = chess::NO_MOVE;
+	this->search.start(this->root, lim, this->history);
+	Position pos = this->root;
+	this->searcher = std::thread([this, pos]{
+		Move best = this->search.run();
+		char name[6], ponder[6];
+		if(best == chess::NO_MOVE){
+			this->send("bestmove 0000");
+			return;
+		}
+		chess::move_name(best, name);
+		// a jogada prevista só serve se vier da mesma linha que a escolhida (a
+		// escolhida pode ser de uma thread auxiliar)
+		Position after = pos;
+		chess::StateInfo st;
+		after.do_move(best, st);
+		if(this->ponderBest == best && this->ponderMove != chess::NO_MOVE && after.is_legal(this->ponderMove)){
+			chess::move_name(this->ponderMove, ponder);
+			this->send("bestmove %s ponder %s", name, ponder);
+		} else {
+			this->send("bestmove %s", name);
+		}
+	});
+}
+
+bool Engine::execute(const std::string &line){
+	std::istringstream is(line);
+	std::string cmd;
+	if(!(is >> cmd)){
+		return true;
+	}
+
+	if(cmd == "uci"){
+		this->cmd_uci();
+	} else if(cmd == "isready"){
+		this->send("readyok");
+	} else if(cmd == "setoption"){
+		this->cmd_setoption(is);
+	} else if(cmd == "ucinewgame"){
+		this->wait();
+		this->tt.clear();
+		this->search.clear();
+	} else if(cmd == "position"){
+		this->cmd_position(is);
+	} else if(cmd == "go"){
+		this->cmd_go(is);
+	} else if(cmd == "stop"){
+		this->search.stop();
+		this->wait();
+	} else if(cmd == "ponderhit"){
+		this->search.ponderhit();
+	} else if(cmd == "quit"){
+		return false;
+	} else {
+		this->send("info string comando desconhecido: %s", cmd.c_str());
+	}
+	return true;
+}
+
+int main(void){
+	chess::init();
+	Engine engine;
+	std::string line;
+	while(std::getline(std::cin, line)){
+		if(!engine.execute(line)){
+			break;
+		}
+	}
+	return 0;
+}